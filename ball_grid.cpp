@@ -0,0 +1,124 @@
+#include "include/ball_grid.h"
+#include "include/globals.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Get the grid column or row of a position along one axis, clamped to the grid.
+ */
+static inline int grid_coord(double p, int count) {
+    int c = static_cast<int>(std::floor(p * (1.0 / BALL_GRID_CELL_SIZE)));
+    return std::clamp(c, 0, count - 1);
+}
+
+void build_ball_grid(BallGrid& grid, const SlotMap<Ball>& balls) {
+    uint32_t n = balls.size();
+    grid.ball_cell.resize(n);
+    grid.items.resize(n);
+    grid.item_pos.resize(n);
+    grid.item_size.resize(n);
+    std::fill(grid.cell_start.begin(), grid.cell_start.end(), 0);
+
+    // counting sort: count each cell's balls, prefix sum into each cell's end, then fill the cells back to front
+    for (uint32_t i = 0; i < n; ++i) {
+        const Ball& b = balls[i];
+        int col = grid_coord(b.pos.x - GAME_AREA_START, BALL_GRID_COLS);
+        int row = grid_coord(b.pos.y, BALL_GRID_ROWS);
+        grid.ball_cell[i] = row * BALL_GRID_COLS + col;
+        ++grid.cell_start[grid.ball_cell[i]];
+    }
+    for (int c = 1; c <= BALL_GRID_CELLS; ++c) {
+        grid.cell_start[c] += grid.cell_start[c - 1];
+    }
+    for (uint32_t i = n; i-- > 0;) {
+        uint32_t k = --grid.cell_start[grid.ball_cell[i]];
+        grid.items[k] = i;
+        grid.item_pos[k] = balls[i].pos;
+        grid.item_size[k] = balls[i].size;
+    }
+}
+
+/**
+ * @brief Add the touching pairs between the balls in [a_first, a_last) and [b_first, b_last) of the grid's items,
+ * with each pair tested once when both ranges are the same cell.
+ * @details The same test as balls_touch(), on the grid's copies of the positions.
+ */
+static void add_cell_pairs(BallGrid& grid, uint32_t a_first, uint32_t a_last, uint32_t b_first, uint32_t b_last) {
+    bool same = a_first == b_first && a_last == b_last;
+    for (uint32_t k = a_first; k < a_last; ++k) {
+        point_2d a = grid.item_pos[k];
+        int a_size = grid.item_size[k];
+        for (uint32_t l = same ? k + 1 : b_first; l < b_last; ++l) {
+            double dx = grid.item_pos[l].x - a.x;
+            double dy = grid.item_pos[l].y - a.y;
+            double reach = a_size + grid.item_size[l];
+            if (dx * dx + dy * dy < reach * reach) {
+                uint32_t i = grid.items[k], j = grid.items[l];
+                grid.pairs.push_back({std::min(i, j), std::max(i, j)});
+            }
+        }
+    }
+}
+
+void find_ball_pairs(BallGrid& grid, const SlotMap<Ball>& balls) {
+    grid.pairs.clear();
+    int largest = 0;
+    for (const Ball& b : balls) {
+        largest = std::max(largest, b.size);
+    }
+    // touching centres are less than two of the largest radius apart
+    int reach = (2 * largest + BALL_GRID_CELL_SIZE - 1) / BALL_GRID_CELL_SIZE;
+
+    // each cell is paired with itself and the cells after it in grid order (the rest of its row and the rows below),
+    // so every pair of neighbouring cells is visited once. The items are in cell order, walking them skips the empty cells
+    for (uint32_t first = 0; first < grid.items.size();) {
+        int c = grid.ball_cell[grid.items[first]];
+        int col = c % BALL_GRID_COLS;
+        int row = c / BALL_GRID_COLS;
+        uint32_t last = grid.cell_start[c + 1];
+        for (int y = row; y <= std::min(row + reach, BALL_GRID_ROWS - 1); ++y) {
+            for (int x = y == row ? col : std::max(col - reach, 0); x <= std::min(col + reach, BALL_GRID_COLS - 1); ++x) {
+                int other = y * BALL_GRID_COLS + x;
+                add_cell_pairs(grid, first, last, grid.cell_start[other], grid.cell_start[other + 1]);
+            }
+        }
+        first = last;
+    }
+    // the cells are visited in grid order, sorting puts the pairs back in index order
+    std::sort(grid.pairs.begin(), grid.pairs.end());
+}
+
+void resolve_ball_pair(Ball& a, Ball& b) {
+    double dx = b.pos.x - a.pos.x;
+    double dy = b.pos.y - a.pos.y;
+    double dist = std::sqrt(dx * dx + dy * dy);
+    // balls exactly on top of each other have no line between them, push them apart sideways
+    double nx = dist > 0 ? dx / dist : 1.0;
+    double ny = dist > 0 ? dy / dist : 0.0;
+
+    double push = (a.size + b.size - dist) * 0.5;
+    if (push > 0) {
+        a.pos.x -= nx * push;
+        a.pos.y -= ny * push;
+        b.pos.x += nx * push;
+        b.pos.y += ny * push;
+    }
+
+    double approach = (b.vel.x - a.vel.x) * nx + (b.vel.y - a.vel.y) * ny;
+    if (approach < 0) {
+        a.vel.x += approach * nx;
+        a.vel.y += approach * ny;
+        b.vel.x -= approach * nx;
+        b.vel.y -= approach * ny;
+    }
+}
+
+int collide_balls(GameState& g) {
+    if (!g.ball_collisions) return 0;
+    build_ball_grid(g.ball_grid, g.balls);
+    find_ball_pairs(g.ball_grid, g.balls);
+    for (auto [i, j] : g.ball_grid.pairs) {
+        resolve_ball_pair(g.balls[i], g.balls[j]);
+    }
+    return static_cast<int>(g.ball_grid.pairs.size());
+}
@@ -3,11 +3,25 @@
 #include "include/state_init.h"
 #include "splashkit.h"
 #include "include/ball_effects.h"
+#include "include/powerup_effects.h"
 #include "include/util.h"
 #include "include/draw.h"
-
-
-void ball_update(Ball& b, GameState& g) {
+#include "include/ball_grid.h"
+#include <array>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief ball_check_block_collision() for balls of a single effect, with the effect call resolved at compile time.
+ */
+template<BallEffectId Effect>
+static void ball_check_block_collision_as(Ball& b, GameState& g);
+
+/**
+ * @brief ball_update() for balls of a single effect.
+ */
+template<BallEffectId Effect>
+static void ball_update_as(Ball& b, GameState& g) {
 
     if (b.pos.y > GAME_AREA_HEIGHT) {
         b.active = false;
@@ -15,44 +29,41 @@ void ball_update(Ball& b, GameState& g) {
         return;
     }
 
-    if (b.ttl_type > 0) {
-        if (b.ttl_type == 2) --b.ttl;
-        if (b.ttl <= 0) {
-            b.active = false;
-            b.trail.clear();
-            return;
-        }
+    // balls out of hits, or expired this tick (update_balls())
+    if (!b.active || (b.ttl_type == 1 && b.ttl <= 0)) {
+        b.active = false;
+        b.trail.clear();
+        return;
     }
 
     b.pos.x += b.vel.x;
     b.pos.y += b.vel.y;
     ball_check_wall_collision(b);
-    ball_check_block_collision(b, g);
+    ball_check_block_collision_as<Effect>(b, g);
     ball_check_paddle_collision(b, g);
-    if (rng.chance(0.25)) {
-        float trail_limiter = rng.randomFloat(0, 1);
-        float xoff = 0.; //rng.randomFloat(-0.5, 0.5);
-        float yoff = 0.; //rng.randomFloat(-0.5, 0.5);
-        b.trail.push_back(new_particle(b.pos, {-b.vel.x * trail_limiter + xoff, -b.vel.y * trail_limiter + yoff}, b.clr, rng.randomInt(1, 3), 30));
-    }
     trail_update(b);
 }
 
 void ball_destroy(Ball& b, GameState& g) {
-    for (int i = 0; i < 60; ++i) {
-        vector_2d particle_vel = {rng.randomFloat(-4.0f, 4.0f), rng.randomFloat(-4.0f, 4.0f)};
-        g.particles.push_back(new_particle(b.pos, particle_vel, b.clr, rng.randomInt(1,2), 60));
+    float vel[60 * 2];
+    int size[60];
+    int n = particle_budget(g, 60);
+    int ttl = particle_ttl(g, 60);
+    g.rng.cosmetic.fillFloats(vel, n * 2, -4.0f, 4.0f);
+    g.rng.cosmetic.fillInts(size, n, 1, 2);
+    for (int i = 0; i < n; ++i) {
+        vector_2d particle_vel = {vel[i * 2], vel[i * 2 + 1]};
+        spawn_particle(g, new_particle(b.pos, particle_vel, b.clr, size[i], ttl));
     }
 }
 
 void trail_update(Ball& b) {
-    for (auto& p : b.trail) {
-        particle_update(p);
+    if (!b.trail.empty()) {
+        const point_2d& last = b.trail[b.trail.size() - 1];
+        double dx = b.pos.x - last.x, dy = b.pos.y - last.y;
+        if (dx * dx + dy * dy < BALL_TRAIL_SPACING * BALL_TRAIL_SPACING) return;
     }
-    // Remove dead particles
-    b.trail.erase(std::remove_if(b.trail.begin(), b.trail.end(),
-                                 [](const Particle& p) { return p.ttl <= 0; }),
-                  b.trail.end());
+    b.trail.push(b.pos);
 }
 
 void ball_check_wall_collision(Ball& b) {
@@ -70,47 +81,64 @@ void ball_check_wall_collision(Ball& b) {
     }
 }
 
-void ball_check_block_collision(Ball& b, GameState& g) {
-    for (auto& row : g.terrain) {
-        for (auto& block : row) {
-            if (block && block->active) {
-                // Check for collision
-                if (b.pos.x < block->pos.x + block->width && b.pos.x + b.size > block->pos.x &&
-                    b.pos.y < block->pos.y + block->height && b.pos.y + b.size > block->pos.y) {
-                    block->active = false;
-
-                    // Determine collision direction
-                    float overlapLeft = (block->pos.x + block->width) - b.pos.x;
-                    float overlapRight = (b.pos.x + b.size) - block->pos.x;
-                    float overlapTop = (block->pos.y + block->height) - b.pos.y;
-                    float overlapBottom = (b.pos.y + b.size) - block->pos.y;
-
-                    // block effect
-                    if (rng.chance(BLOCK_POWERUP_CHANCE)) {
-                        Ball nb = roll_ball();
-                        nb.pos = {block->pos.x + block->width / 2, block->pos.y + block->height / 2};
-                        g.balls.push_back(nb);
-                        for (int i = 0; i < 15; ++i) {
-                            vector_2d particle_vel = {rng.randomFloat(-2.0f, 2.0f), rng.randomFloat(-2.0f, 2.0f)};
-                            g.particles.push_back(new_particle(block->pos, particle_vel, nb.clr, 2, 60));
-                        }
+template<BallEffectId Effect>
+static void ball_check_block_collision_as(Ball& b, GameState& g) {
+    // only blocks with an empty neighbour can be reached, the interior of the terrain is skipped entirely
+    // (the row is re-read after every cell, a hit can expose more of it)
+    // acid balls are the exception: they pass through the blocks they hit, which stay until their erosion comes up,
+    // so a ball can get ahead of the erosion and into the interior, where it still has to hit (and erode) every block
+    const Occupancy& candidates = Effect == EFFECT_ACID ? g.occupancy : g.exposed;
+    // the columns don't move, so only the ones the ball spans can be hit
+    int first_col = static_cast<int>(std::floor((b.pos.x - TERRAIN_OFFSET) / BLOCK_WIDTH));
+    int last_col = static_cast<int>(std::floor((b.pos.x + b.size - TERRAIN_OFFSET) / BLOCK_WIDTH));
+    RowBits columns = span_mask(first_col, last_col);
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        RowBits checked = 0;
+        for (RowBits cells = candidates[y] & columns; cells; cells = candidates[y] & columns & ~checked) {
+            int x = lowest_bit(cells);
+            checked |= cell_bit(x);
+            // Check for collision
+            double block_x = TERRAIN_OFFSET + x * BLOCK_WIDTH;
+            double block_y = g.terrain.y[cell_index(x, y)];
+            if (b.pos.x < block_x + BLOCK_WIDTH && b.pos.x + b.size > block_x &&
+                b.pos.y < block_y + BLOCK_HEIGHT && b.pos.y + b.size > block_y) {
+                damage_block(g, {x, y});
+
+                // Determine collision direction
+                float overlapLeft = (block_x + BLOCK_WIDTH) - b.pos.x;
+                float overlapRight = (b.pos.x + b.size) - block_x;
+                float overlapTop = (block_y + BLOCK_HEIGHT) - b.pos.y;
+                float overlapBottom = (b.pos.y + b.size) - block_y;
+
+                // block effect
+                if (g.rng.gameplay.chance(BLOCK_POWERUP_CHANCE)) {
+                    PowerUp pu = roll_powerup(g.rng.gameplay);
+                    pu.pos = {block_x + BLOCK_WIDTH / 2, block_y + BLOCK_HEIGHT / 2};
+                    spawn_powerup(g, pu);
+                    float vel[15 * 2];
+                    int n = particle_budget(g, 15);
+                    int ttl = particle_ttl(g, 60);
+                    g.rng.cosmetic.fillFloats(vel, n * 2, -2.0f, 2.0f);
+                    for (int i = 0; i < n; ++i) {
+                        vector_2d particle_vel = {vel[i * 2], vel[i * 2 + 1]};
+                        spawn_particle(g, new_particle({block_x, block_y}, particle_vel, pu.clr, 2, ttl));
                     }
+                }
 
-                    if (b.ttl_type == 1) --b.ttl;
-                    // Call the block effect, effect function should return false if the ball trajectory won't change
-                    // as is the case with acid for example
-                    bool should_vel = b.effect(b, block->grid_pos, g);
-                    if (!should_vel) {
-                        return;
-                    }
+                if (b.ttl_type == 1) --b.ttl;
+                // Call the block effect, effect function should return false if the ball trajectory won't change
+                // as is the case with acid for example
+                bool should_vel = BALL_EFFECTS[Effect](b, {x, y}, g);
+                if (!should_vel) {
+                    return;
+                }
 
-                    bool x_overlap = std::min(overlapLeft, overlapRight) < std::min(overlapTop, overlapBottom);
-                    // Reverse velocity based on the smallest overlap
-                    if (x_overlap) {
-                        b.vel.x *= -1; // Horizontal collision
-                    } else {
-                        b.vel.y *= -1; // Vertical collision
-                    }
+                bool x_overlap = std::min(overlapLeft, overlapRight) < std::min(overlapTop, overlapBottom);
+                // Reverse velocity based on the smallest overlap
+                if (x_overlap) {
+                    b.vel.x *= -1; // Horizontal collision
+                } else {
+                    b.vel.y *= -1; // Vertical collision
                 }
             }
         }
@@ -125,13 +153,86 @@ void ball_check_paddle_collision(Ball& b, GameState& g) {
 }
 
 
-void update_balls(GameState& g) {
-    for (auto& b : g.balls) {
-        ball_update(b, g);
+/**
+ * @brief Update the balls in [first, last), which all share the given effect.
+ */
+template<BallEffectId Effect>
+static void update_ball_bucket(GameState& g, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        Ball& b = g.balls[i];
+        ball_update_as<Effect>(b, g);
         if (!b.active) {
             ball_destroy(b, g);
         }
     }
-    g.balls.erase(remove_if(g.balls.begin(), g.balls.end(), [](const Ball& b) { return !b.active; }), g.balls.end());
+}
+
+using BallUpdate = void (*)(Ball& b, GameState& g);
+using BallBucketUpdate = void (*)(GameState& g, size_t first, size_t last);
+
+template<size_t... Ids>
+static constexpr std::array<BallUpdate, sizeof...(Ids)> ball_update_table(std::index_sequence<Ids...>) {
+    return {ball_update_as<static_cast<BallEffectId>(Ids)>...};
+}
+
+template<size_t... Ids>
+static constexpr std::array<BallUpdate, sizeof...(Ids)> ball_collision_table(std::index_sequence<Ids...>) {
+    return {ball_check_block_collision_as<static_cast<BallEffectId>(Ids)>...};
+}
+
+template<size_t... Ids>
+static constexpr std::array<BallBucketUpdate, sizeof...(Ids)> ball_bucket_update_table(std::index_sequence<Ids...>) {
+    return {update_ball_bucket<static_cast<BallEffectId>(Ids)>...};
+}
+
+/**
+ * @brief The per-effect instantiations, indexed by BallEffectId (generated so new effects are picked up automatically).
+ */
+static constexpr auto BALL_UPDATES = ball_update_table(std::make_index_sequence<NUM_BALL_EFFECTS>());
+static constexpr auto BALL_BLOCK_COLLISIONS = ball_collision_table(std::make_index_sequence<NUM_BALL_EFFECTS>());
+static constexpr auto BALL_BUCKET_UPDATES = ball_bucket_update_table(std::make_index_sequence<NUM_BALL_EFFECTS>());
+
+void ball_update(Ball& b, GameState& g) {
+    BALL_UPDATES[b.effect](b, g);
+}
+
+void ball_check_block_collision(Ball& b, GameState& g) {
+    BALL_BLOCK_COLLISIONS[b.effect](b, g);
+}
+
+Handle spawn_ball(GameState& g, Ball b) {
+    b.birth = g.tick;
+    bool timed = b.ttl_type == 2;
+    uint32_t due = b.birth + b.ttl;
+    Handle h = g.balls.insert(std::move(b));
+    if (timed) {
+        g.ball_timers.schedule(h, due, g.tick);
+    }
+    return h;
+}
+
+void update_balls(GameState& g) {
+    g.ball_timers.expire(g.tick, [&](Handle h) {
+        if (Ball* b = g.balls.get(h)) b->active = false;
+    });
+    // keep the balls grouped by effect, the order only breaks when new balls are added
+    auto by_effect = [](const Ball& l, const Ball& r) { return l.effect < r.effect; };
+    if (!std::is_sorted(g.balls.begin(), g.balls.end(), by_effect)) {
+        g.balls.sort(by_effect);
+    }
+    // then run each effect's bucket as one loop
+    for (size_t first = 0; first < g.balls.size();) {
+        BallEffectId effect = g.balls[first].effect;
+        size_t last = first;
+        while (last < g.balls.size() && g.balls[last].effect == effect) {
+            ++last;
+        }
+        BALL_BUCKET_UPDATES[effect](g, first, last);
+        first = last;
+    }
+    // order preserving removal, so the balls stay grouped
+    g.balls.remove_if([](const Ball& b) { return !b.active; });
+    // the balls bounce off each other once they've all moved
+    collide_balls(g);
 }
 
@@ -4,25 +4,47 @@
 #include "include/draw.h"
 
 
-void block_update(Block& b, GameState& g) {
-    if (!b.active) {
-        block_destroy(b, g);
+void block_update(GameState& g, ivec2 cell) {
+    int i = cell_index(cell.x, cell.y);
+    if (g.terrain.hp[i] == 0) {
+        block_destroy(g, cell);
         return;
     }
-    if (b.pos.y < b.target_pos.y) {
-        b.y_vel += 0.1;
-        b.pos.y += b.y_vel;
-        if (b.pos.y >= b.target_pos.y) {
-            b.pos.y = b.target_pos.y;
-            b.y_vel = 0;
+    float target_y = cell.y * BLOCK_HEIGHT;
+    if (g.terrain.y[i] < target_y) {
+        g.terrain.y_vel[i] += 0.1f;
+        g.terrain.y[i] += g.terrain.y_vel[i];
+        if (g.terrain.y[i] >= target_y) {
+            g.terrain.y[i] = target_y;
+            g.terrain.y_vel[i] = 0;
         }
     }
 }
 
-void block_destroy(const Block& b, GameState& g) {
+void block_destroy(GameState& g, ivec2 cell) {
     ++g.score;
-    for (int i = 0; i < 2; ++i) {
-        vector_2d particle_vel = {rng.randomFloat(-2.0f, 2.0f), rng.randomFloat(2.0f, 0.0f)}; // can't have upward trajectory
-        g.particles.push_back(new_particle(b.pos, particle_vel, b.clr, rng.randomInt(1,2), 90));
+    int i = cell_index(cell.x, cell.y);
+    point_2d pos = {static_cast<double>(TERRAIN_OFFSET + cell.x * BLOCK_WIDTH), g.terrain.y[i]};
+    color clr = block_color(g, cell);
+    int n = particle_budget(g, 2);
+    int ttl = particle_ttl(g, 90);
+    for (int j = 0; j < n; ++j) {
+        vector_2d particle_vel = {g.rng.cosmetic.randomFloat(-2.0f, 2.0f), g.rng.cosmetic.randomFloat(2.0f, 0.0f)}; // can't have upward trajectory
+        spawn_particle(g, new_particle(pos, particle_vel, clr, g.rng.cosmetic.randomInt(1,2), ttl));
+    }
+    // the debris has its colour, nothing is left of the block
+    RowBits bit = cell_bit(cell.x);
+    g.explosive[cell.y] &= ~bit;
+    g.eroded[cell.y] &= ~bit;
+}
+
+color block_color(const GameState& g, ivec2 cell) {
+    RowBits bit = cell_bit(cell.x);
+    if (g.explosive[cell.y] & bit) return clr_block_explosive;
+    if (g.eroded[cell.y] & bit) return clr_ball_acid;
+    switch (g.terrain.hp[cell_index(cell.x, cell.y)]) {
+        case 2: return clr_block_tough;
+        case 3: return clr_block_hard;
+        default: return clr_block;
     }
 }
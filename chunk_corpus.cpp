@@ -0,0 +1,239 @@
+#include "include/chunk_corpus.h"
+#include "include/globals.h"
+#include "include/state_init.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CORPUS_MMAP 1
+#endif
+
+static const char CORPUS_MAGIC[4] = {'B', 'R', 'K', 'C'};
+
+/**
+ * @brief Size of the header: magic, version, grid dimensions, chunk count and padding.
+ */
+static constexpr size_t CORPUS_HEADER_SIZE = 16;
+
+/**
+ * @brief Size of the size table: first chunk and chunk count of each number of rows.
+ */
+static constexpr size_t CORPUS_SIZES_SIZE = NUM_ROWS * 2 * sizeof(uint32_t);
+
+/**
+ * @brief Size of an index record: data offset, pattern, rows and padding.
+ */
+static constexpr size_t CORPUS_RECORD_SIZE = 8;
+
+static constexpr uint64_t CELL_MASK = (uint64_t(1) << CORPUS_BITS_PER_CELL) - 1;
+
+// the file is only ever read with memcpy, so a section's alignment is a speed matter, not a correctness one
+template<typename T>
+static T get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template<typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+
+// WRITE
+bool save_chunk_corpus(const std::vector<CorpusEntry>& entries, const std::string& path) {
+    std::vector<const CorpusEntry*> sorted;
+    for (const auto& entry : entries) {
+        if (entry.chunk.rows > 0 && entry.chunk.rows <= NUM_ROWS) {
+            sorted.push_back(&entry);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const CorpusEntry* a, const CorpusEntry* b) {
+        return a->chunk.rows < b->chunk.rows;
+    });
+
+    std::vector<uint8_t> out;
+    for (char c : CORPUS_MAGIC) {
+        put<char>(out, c);
+    }
+    put<uint16_t>(out, CHUNK_CORPUS_VERSION);
+    put<uint8_t>(out, NUM_ROWS);
+    put<uint8_t>(out, NUM_COLS);
+    put<uint32_t>(out, sorted.size());
+    put<uint32_t>(out, 0);
+
+    uint32_t first[NUM_ROWS] = {};
+    uint32_t count[NUM_ROWS] = {};
+    for (uint32_t i = 0; i < sorted.size(); ++i) {
+        int size = sorted[i]->chunk.rows - 1;
+        if (count[size]++ == 0) first[size] = i;
+    }
+    for (int size = 0; size < NUM_ROWS; ++size) {
+        put<uint32_t>(out, first[size]);
+        put<uint32_t>(out, count[size]);
+    }
+
+    uint32_t offset = 0;
+    for (const CorpusEntry* entry : sorted) {
+        put<uint32_t>(out, offset);
+        put<uint8_t>(out, entry->pattern);
+        put<uint8_t>(out, entry->chunk.rows);
+        put<uint16_t>(out, 0);
+        offset += entry->chunk.rows * sizeof(uint64_t);
+    }
+
+    for (const CorpusEntry* entry : sorted) {
+        const Chunk& chunk = entry->chunk;
+        for (int y = 0; y < chunk.rows; ++y) {
+            uint64_t row = 0;
+            for (int x = 0; x < NUM_COLS; ++x) {
+                uint64_t hp = std::min<uint8_t>(chunk.hp[cell_index(x, y)], MAX_BLOCK_HP);
+                row |= hp << (x * CORPUS_BITS_PER_CELL);
+            }
+            put<uint64_t>(out, row);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(out.data()), out.size());
+    return file.good();
+}
+
+
+// READ
+/**
+ * @brief Map a file read only, or read it into the corpus buffer where there is no mmap.
+ */
+static bool map_file(ChunkCorpus& corpus, const std::string& path) {
+#ifdef CORPUS_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED) return false;
+    corpus.data = static_cast<const uint8_t*>(data);
+    corpus.size = st.st_size;
+    corpus.mapped = true;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    corpus.buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    corpus.data = corpus.buffer.data();
+    corpus.size = corpus.buffer.size();
+    corpus.mapped = false;
+#endif
+    return true;
+}
+
+/**
+ * @brief Check a mapped corpus and fill in its size table and section pointers.
+ */
+static bool parse_corpus(ChunkCorpus& corpus) {
+    const uint8_t* p = corpus.data;
+    if (corpus.size < CORPUS_HEADER_SIZE + CORPUS_SIZES_SIZE) return false;
+    if (std::memcmp(p, CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) != 0) return false;
+    if (get<uint16_t>(p + 4) != CHUNK_CORPUS_VERSION || get<uint8_t>(p + 6) != NUM_ROWS || get<uint8_t>(p + 7) != NUM_COLS) {
+        return false;
+    }
+    uint32_t num_chunks = get<uint32_t>(p + 8);
+    size_t data_start = CORPUS_HEADER_SIZE + CORPUS_SIZES_SIZE + static_cast<size_t>(num_chunks) * CORPUS_RECORD_SIZE;
+    if (data_start > corpus.size) return false;
+
+    const uint8_t* sizes = p + CORPUS_HEADER_SIZE;
+    for (int size = 0; size < NUM_ROWS; ++size) {
+        corpus.first[size] = get<uint32_t>(sizes + size * 8);
+        corpus.count[size] = get<uint32_t>(sizes + size * 8 + 4);
+        if (corpus.count[size] > num_chunks || corpus.first[size] > num_chunks - corpus.count[size]) return false;
+    }
+
+    const uint8_t* index = sizes + CORPUS_SIZES_SIZE;
+    size_t data_size = corpus.size - data_start;
+    for (uint32_t i = 0; i < num_chunks; ++i) {
+        const uint8_t* record = index + static_cast<size_t>(i) * CORPUS_RECORD_SIZE;
+        uint32_t offset = get<uint32_t>(record);
+        uint8_t pattern = get<uint8_t>(record + 4);
+        uint8_t rows = get<uint8_t>(record + 5);
+        if (pattern >= NUM_PATTERNS || rows == 0 || rows > NUM_ROWS) return false;
+        if (offset > data_size || rows * sizeof(uint64_t) > data_size - offset) return false;
+    }
+    // the size table has to agree with the index, random_corpus_chunk() trusts it for the rows
+    for (int size = 0; size < NUM_ROWS; ++size) {
+        for (uint32_t i = corpus.first[size]; i < corpus.first[size] + corpus.count[size]; ++i) {
+            if (get<uint8_t>(index + static_cast<size_t>(i) * CORPUS_RECORD_SIZE + 5) != size + 1) return false;
+        }
+    }
+
+    corpus.num_chunks = num_chunks;
+    corpus.index = index;
+    corpus.chunk_data = p + data_start;
+    return true;
+}
+
+bool open_chunk_corpus(ChunkCorpus& corpus, const std::string& path) {
+    close_chunk_corpus(corpus);
+    if (!map_file(corpus, path)) return false;
+    if (!parse_corpus(corpus)) {
+        close_chunk_corpus(corpus);
+        return false;
+    }
+    // 64-bit FNV-1a over the whole file
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < corpus.size; ++i) {
+        hash ^= corpus.data[i];
+        hash *= 0x100000001B3ull;
+    }
+    corpus.hash = hash ? hash : 1;
+    return true;
+}
+
+void close_chunk_corpus(ChunkCorpus& corpus) {
+#ifdef CORPUS_MMAP
+    if (corpus.mapped && corpus.data) {
+        munmap(const_cast<uint8_t*>(corpus.data), corpus.size);
+    }
+#endif
+    corpus = new_chunk_corpus();
+}
+
+uint32_t corpus_count(const ChunkCorpus& corpus, int rows) {
+    return rows >= 1 && rows <= NUM_ROWS ? corpus.count[rows - 1] : 0;
+}
+
+PatternKind corpus_pattern(const ChunkCorpus& corpus, uint32_t i) {
+    return static_cast<PatternKind>(get<uint8_t>(corpus.index + static_cast<size_t>(i) * CORPUS_RECORD_SIZE + 4));
+}
+
+void corpus_chunk(const ChunkCorpus& corpus, uint32_t i, Chunk& out) {
+    const uint8_t* record = corpus.index + static_cast<size_t>(i) * CORPUS_RECORD_SIZE;
+    const uint8_t* rows_data = corpus.chunk_data + get<uint32_t>(record);
+    out.rows = get<uint8_t>(record + 5);
+    out.hp.resize(out.rows * NUM_COLS);
+    for (int y = 0; y < out.rows; ++y) {
+        uint64_t row = get<uint64_t>(rows_data + y * sizeof(uint64_t));
+        uint8_t* cells = out.hp.data() + cell_index(0, y);
+        for (int x = 0; x < NUM_COLS; ++x, row >>= CORPUS_BITS_PER_CELL) {
+            cells[x] = static_cast<uint8_t>(row & CELL_MASK);
+        }
+    }
+}
+
+bool random_corpus_chunk(const ChunkCorpus& corpus, int rows, XOR& rng, Chunk& out) {
+    uint32_t count = corpus_count(corpus, rows);
+    if (count == 0) return false;
+    uint32_t i = corpus.first[rows - 1] + static_cast<uint32_t>(rng.randomInt(0, static_cast<int>(count) - 1));
+    corpus_chunk(corpus, i, out);
+    return true;
+}
@@ -1,60 +1,105 @@
 #include "include/draw.h"
 #include "include/globals.h"
+#include "include/state_management.h"
 
-void draw_global_state(const GameState& g) {
-    clear_screen(clr_background);
-    fill_rectangle(color_from_hex("#FBF6E0"), GAME_AREA_START - 3, 0, GAME_AREA_WIDTH + 6, GAME_AREA_HEIGHT - 3);
-    fill_rectangle(clr_background, GAME_AREA_START, 0, GAME_AREA_WIDTH, GAME_AREA_HEIGHT);
-    draw_text("score: " + std::to_string(g.score), COLOR_WHITE, 20, 20, option_to_screen());
-    draw_particles(g);
-    draw_terrain(g);
-    paddle_draw(g);
-    draw_balls(g);
+void draw_global_state(const GameState& g, Renderer& r) {
+    render_begin_pass(r, PASS_BACKGROUND);
+    render_clear(r, clr_background);
+    render_fill_rect(r, color_from_hex("#FBF6E0"), GAME_AREA_START - 3, 0, GAME_AREA_WIDTH + 6, GAME_AREA_HEIGHT - 3);
+    render_fill_rect(r, clr_background, GAME_AREA_START, 0, GAME_AREA_WIDTH, GAME_AREA_HEIGHT);
+    render_text(r, "score: " + std::to_string(g.score), COLOR_WHITE, 20, 20);
+    render_end_pass(r);
+
+    render_begin_pass(r, PASS_PARTICLES);
+    draw_particles(g, r);
+    render_end_pass(r);
+
+    render_begin_pass(r, PASS_TERRAIN);
+    draw_terrain(g, r);
+    render_end_pass(r);
+
+    render_begin_pass(r, PASS_POWERUPS);
+    draw_powerups(g, r);
+    render_end_pass(r);
+
+    render_begin_pass(r, PASS_PADDLE);
+    paddle_draw(g, r);
+    render_end_pass(r);
+
+    render_begin_pass(r, PASS_BALLS);
+    draw_balls(g, r);
+    render_end_pass(r);
+    ++r.frames;
 }
 
-void trail_draw(const Ball& b) {
-    for (auto& p : b.trail) {
-        particle_draw(p);
+void trail_draw(const Ball& b, Renderer& r) {
+    // oldest first, ending at the ball so the ribbon meets it
+    RibbonPoint points[BALL_TRAIL_LENGTH + 1];
+    int count = b.trail.size();
+    for (int i = 0; i <= count; ++i) {
+        point_2d p = i < count ? b.trail[i] : b.pos;
+        float t = static_cast<float>(i + 1) / (count + 1);
+        points[i] = {static_cast<float>(p.x), static_cast<float>(p.y), b.size * t, 0.6f * t};
     }
+    render_fill_ribbon(r, b.clr, points, count + 1);
 }
 
-void ball_draw(const Ball& b) {
-    trail_draw(b);
-    fill_circle(b.clr, b.pos.x, b.pos.y, b.size);
+void ball_draw(const Ball& b, Renderer& r) {
+    trail_draw(b, r);
+    render_fill_circle(r, b.clr, b.pos.x, b.pos.y, b.size);
 }
 
-void draw_balls(const GameState& g) {
+void draw_balls(const GameState& g, Renderer& r) {
     for (auto& b : g.balls) {
-        ball_draw(b);
+        ball_draw(b, r);
     }
 }
 
-void block_draw(const Block& b) {
-    if (b.active) {
-        fill_rectangle(b.clr, b.pos.x, b.pos.y, b.width, b.height);}
+void block_draw(const GameState& g, ivec2 cell, Renderer& r) {
+    double x = TERRAIN_OFFSET + cell.x * BLOCK_WIDTH;
+    render_fill_rect(r, block_color(g, cell), x, g.terrain.y[cell_index(cell.x, cell.y)], BLOCK_WIDTH, BLOCK_HEIGHT);
 }
 
-void paddle_draw(const GameState& g) {
-    fill_rectangle(g.paddle.clr, g.paddle.x, g.paddle.y, g.paddle.width, g.paddle.height);
+void paddle_draw(const GameState& g, Renderer& r) {
+    render_mark_paddle(r);
+    render_fill_rect(r, g.paddle.clr, g.paddle.x, g.paddle.y, g.paddle.width, g.paddle.height);
 }
 
-void draw_terrain(const GameState& g) {
-    for (const auto& row : g.terrain) {
-        for (const auto& block : row) {
-            if (block) {
-                block_draw(*block);
-            }
+void draw_terrain(const GameState& g, Renderer& r) {
+    // every visible block has hit points left, so walk the occupancy instead of every cell
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        for (RowBits occupied = g.occupancy[y]; occupied; occupied &= occupied - 1) {
+            block_draw(g, {lowest_bit(occupied), y}, r);
         }
     }
 }
 
-void particle_draw(const Particle& p) {
-    fill_circle(p.clr, p.pos.x, p.pos.y, p.size);
+void powerup_draw(const PowerUp& p, Renderer& r) {
+    render_fill_circle(r, p.clr, p.pos.x, p.pos.y, p.size);
+    render_fill_circle(r, clr_background, p.pos.x, p.pos.y, p.size / 2);
+}
+
+void draw_powerups(const GameState& g, Renderer& r) {
+    for (uint32_t i = 0; i < g.powerup_trail.size(); ++i) {
+        particle_draw(g.powerup_trail[i], g.tick, r);
+    }
+    for (const auto& p : g.powerups) {
+        powerup_draw(p, r);
+    }
+}
+
+void particle_draw(const Particle& p, uint32_t now, Renderer& r) {
+    // fade in and shrink with age
+    float alpha = particle_lapsed(p, now);
+    color clr = p.clr;
+    clr.a = alpha;
+    int size = static_cast<int>(p.size * (1.0f - (alpha / 2.0f)));
+    render_fill_circle(r, clr, p.pos.x, p.pos.y, size);
 }
 
 
-void draw_particles(const GameState& g) {
+void draw_particles(const GameState& g, Renderer& r) {
     for (auto& p : g.particles) {
-        particle_draw(p);
+        particle_draw(p, g.tick, r);
     }
 }
@@ -1,8 +1,10 @@
 #include "include/state_management.h"
 
 void update_global_state(GameState& g) {
+    ++g.tick;
     update_particles(g);
     update_terrain(g);
     paddle_update(g);
     update_balls(g);
+    update_powerups(g);
 }
@@ -6,10 +6,27 @@
 #include <limits>
 #include <vector>
 
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(XOR_NO_SIMD)
+#include <emmintrin.h>
+#define XOR_SSE2 1
+#endif
+
 /**
  * @brief Simple random number generator based on XOR shift algorithm.
+ * @details Alongside the main stream the generator keeps LANES interleaved xorshift streams that the bulk
+ * fill functions step together (4 at a time with SSE2, or one by one in the scalar fallback, which gives the same values).
  */
 struct XOR {
+    /**
+     * @brief The number of interleaved streams used by the bulk fill functions.
+     */
+    static constexpr int LANES = 4;
+
+    /**
+     * @brief The number of words in the full generator state (main stream plus lanes).
+     */
+    static constexpr int STATE_WORDS = 1 + LANES;
+
     /**
      * @brief Constructor for XOR random number generator.
      * @param initialSeed The initial seed value for the generator.
@@ -24,6 +41,13 @@ struct XOR {
      */
     inline int randomInt(int min, int max);
 
+    /**
+     * @brief Generates a random 32-bit word, every value equally likely.
+     * @details For seeds and hashes, which want the full range randomInt() can't span.
+     * @return A random word.
+     */
+    inline uint32_t randomWord();
+
     /**
      * @brief Generates a random float in the range [min, max].
      * @param min The minimum value of the range.
@@ -56,6 +80,47 @@ struct XOR {
     template<typename T, size_t N>
     inline T choose(const T (&arr)[N]);
 
+    /**
+     * @brief Fills an array with random floats in the range [min, max).
+     * @details Drawn from the interleaved lane streams, so the values don't come from (or advance) the main stream
+     * and differ from calling randomFloat() count times. Reproducible for a given seed and sequence of calls.
+     * @param out The array to fill.
+     * @param count The number of values to generate.
+     * @param min The minimum value of the range.
+     * @param max The maximum value of the range.
+     */
+    inline void fillFloats(float* out, int count, float min = 0.0f, float max = 1.0f);
+
+    /**
+     * @brief Fills an array with random integers in the range [min, max].
+     * @details Drawn from the interleaved lane streams like fillFloats().
+     * @param out The array to fill.
+     * @param count The number of values to generate.
+     * @param min The minimum value of the range.
+     * @param max The maximum value of the range.
+     */
+    inline void fillInts(int* out, int count, int min, int max);
+
+    /**
+     * @brief Splits off an independent generator.
+     * @details The child is seeded from the parent's next output passed through an integer finalizer,
+     * so the two streams don't track each other. Advances the parent by one step.
+     * @return The new generator.
+     */
+    inline XOR split();
+
+    /**
+     * @brief Copies out the full generator state, so it can be saved and restored exactly.
+     * @param out The array to write STATE_WORDS words to.
+     */
+    inline void saveState(uint32_t out[STATE_WORDS]) const;
+
+    /**
+     * @brief Restores a state previously written by saveState().
+     * @param in The array of STATE_WORDS words to read.
+     */
+    inline void loadState(const uint32_t in[STATE_WORDS]);
+
 private:
     /**
      * @brief Generates the next random number in the sequence.
@@ -63,12 +128,48 @@ private:
      */
     inline uint32_t next();
 
+    /**
+     * @brief Steps every lane stream once (scalar path).
+     * @param out The new value of each lane.
+     */
+    inline void nextLanes(uint32_t out[LANES]);
+
+    /**
+     * @brief Integer finalizer used to derive decorrelated seeds.
+     * @param x The value to mix.
+     * @return The mixed (non-zero) value.
+     */
+    static inline uint32_t mix(uint32_t x);
+
     uint32_t seed; ///< The current seed value for the generator.
+    uint32_t lanes[LANES]; ///< The current seed value of each interleaved stream.
 };
 
 // Inline function definitions
 
-inline XOR::XOR(uint32_t initialSeed) : seed(initialSeed) {}
+inline XOR::XOR(uint32_t initialSeed) : seed(initialSeed) {
+    for (int i = 0; i < LANES; ++i) {
+        lanes[i] = mix(initialSeed + static_cast<uint32_t>(i + 1) * 0x9E3779B9u);
+    }
+}
+
+inline uint32_t XOR::mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+    return x ? x : 0x77777777; // xorshift is stuck at zero
+}
+
+inline void XOR::nextLanes(uint32_t out[LANES]) {
+    for (int i = 0; i < LANES; ++i) {
+        lanes[i] ^= lanes[i] << 13;
+        lanes[i] ^= lanes[i] >> 17;
+        lanes[i] ^= lanes[i] << 5;
+        out[i] = lanes[i];
+    }
+}
 
 inline uint32_t XOR::next() {
     seed ^= seed << 13;
@@ -77,6 +178,10 @@ inline uint32_t XOR::next() {
     return seed;
 }
 
+inline uint32_t XOR::randomWord() {
+    return next();
+}
+
 inline int XOR::randomInt(int min, int max) {
     if (max < min) {
         std::swap(min, max);
@@ -107,3 +212,92 @@ template<typename T, size_t N>
 inline T XOR::choose(const T (&arr)[N]) {
     return arr[randomInt(0, N - 1)];
 }
+
+// The bulk fills keep to the top 24 bits for floats (exact int -> float conversion) and use a multiply-high
+// instead of % for ints, so the SIMD and scalar paths compute exactly the same values.
+inline void XOR::fillFloats(float* out, int count, float min, float max) {
+    const float scale = 1.0f / 16777216.0f;
+    const float range = max - min;
+#ifdef XOR_SSE2
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+    const __m128 v_scale = _mm_set1_ps(scale);
+    const __m128 v_range = _mm_set1_ps(range);
+    const __m128 v_min = _mm_set1_ps(min);
+    for (int i = 0; i < count; i += LANES) {
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+        s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+        __m128 unit = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s, 8)), v_scale);
+        __m128 values = _mm_add_ps(v_min, _mm_mul_ps(unit, v_range));
+        if (count - i >= LANES) {
+            _mm_storeu_ps(out + i, values);
+        } else {
+            float tail[LANES];
+            _mm_storeu_ps(tail, values);
+            std::copy(tail, tail + (count - i), out + i);
+        }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), s);
+#else
+    uint32_t v[LANES];
+    for (int i = 0; i < count; i += LANES) {
+        nextLanes(v);
+        for (int l = 0; l < LANES && i + l < count; ++l) {
+            float unit = static_cast<float>(v[l] >> 8) * scale;
+            out[i + l] = min + unit * range;
+        }
+    }
+#endif
+}
+
+inline void XOR::fillInts(int* out, int count, int min, int max) {
+    if (max < min) {
+        std::swap(min, max);
+    }
+    const uint32_t range = static_cast<uint32_t>(max - min + 1);
+#ifdef XOR_SSE2
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+    const __m128i v_range = _mm_set1_epi32(static_cast<int>(range));
+    const __m128i v_min = _mm_set1_epi32(min);
+    const __m128i odd_mask = _mm_set_epi32(-1, 0, -1, 0);
+    for (int i = 0; i < count; i += LANES) {
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+        s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+        s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+        // high 32 bits of lane * range: lanes 0 and 2 from the even products, 1 and 3 from the odd ones
+        __m128i even = _mm_srli_epi64(_mm_mul_epu32(s, v_range), 32);
+        __m128i odd = _mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(s, 32), v_range), odd_mask);
+        __m128i values = _mm_add_epi32(v_min, _mm_or_si128(even, odd));
+        if (count - i >= LANES) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), values);
+        } else {
+            int tail[LANES];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(tail), values);
+            std::copy(tail, tail + (count - i), out + i);
+        }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), s);
+#else
+    uint32_t v[LANES];
+    for (int i = 0; i < count; i += LANES) {
+        nextLanes(v);
+        for (int l = 0; l < LANES && i + l < count; ++l) {
+            out[i + l] = min + static_cast<int>((static_cast<uint64_t>(v[l]) * range) >> 32);
+        }
+    }
+#endif
+}
+
+inline XOR XOR::split() {
+    return XOR(mix(next() ^ 0x9E3779B9u));
+}
+
+inline void XOR::saveState(uint32_t out[STATE_WORDS]) const {
+    out[0] = seed;
+    std::copy(lanes, lanes + LANES, out + 1);
+}
+
+inline void XOR::loadState(const uint32_t in[STATE_WORDS]) {
+    seed = in[0];
+    std::copy(in + 1, in + 1 + LANES, lanes);
+}
@@ -17,10 +17,17 @@ bool ball_standard(Ball& b, ivec2 grid_pos, GameState& g);
 bool ball_explosion(Ball& b, ivec2 grid_pos, GameState& g);
 bool ball_acid(Ball& b, ivec2 grid_pos, GameState& g);
 
+/**
+ * @brief The ball effect functions, indexed by BallEffectId.
+ *
+ */
+inline constexpr BallEffect BALL_EFFECTS[NUM_BALL_EFFECTS] = {ball_standard, ball_explosion, ball_acid};
+
 // util
 /**
  * @brief Generate a ball with a randomly selected effect.
  *
+ * @param rng The random number generator to roll with.
  * @return Ball The generated ball.
  */
-Ball roll_ball();
+Ball roll_ball(XOR& rng);
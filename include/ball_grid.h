@@ -0,0 +1,56 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Check if two balls overlap.
+ *
+ * @param a The first ball.
+ * @param b The second ball.
+ * @return true If the balls' circles overlap.
+ */
+inline bool balls_touch(const Ball& a, const Ball& b) {
+    double dx = b.pos.x - a.pos.x;
+    double dy = b.pos.y - a.pos.y;
+    double reach = a.size + b.size;
+    return dx * dx + dy * dy < reach * reach;
+}
+
+/**
+ * @brief Rebuild the ball grid from the balls' positions.
+ * @details Balls outside the game area are hashed into the nearest edge cell.
+ *
+ * @param grid The ball grid.
+ * @param balls The balls.
+ */
+void build_ball_grid(BallGrid& grid, const SlotMap<Ball>& balls);
+
+/**
+ * @brief Find every pair of touching balls through the ball grid, into grid.pairs.
+ * @details Each ball is only tested against the balls in the cells around it (how many cells out depends on the largest ball),
+ * so the cost grows with the number of balls and how crowded they are, not the number of pairs.
+ * The pairs come out in the order a test of every pair would find them in.
+ *
+ * @param grid The ball grid, built from the balls.
+ * @param balls The balls.
+ */
+void find_ball_pairs(BallGrid& grid, const SlotMap<Ball>& balls);
+
+/**
+ * @brief Bounce two touching balls off each other.
+ * @details The balls are pushed apart until they no longer overlap and, if they are moving towards each other,
+ * swap their velocities along the line between their centres (an elastic collision between equal masses).
+ *
+ * @param a The first ball.
+ * @param b The second ball.
+ */
+void resolve_ball_pair(Ball& a, Ball& b);
+
+/**
+ * @brief Bounce every pair of touching balls off each other.
+ * @details Rebuilds the ball grid and resolves the pairs it finds in order. Does nothing when g.ball_collisions is off.
+ *
+ * @param g The game state.
+ * @return int The number of pairs resolved.
+ */
+int collide_balls(GameState& g);
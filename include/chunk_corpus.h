@@ -0,0 +1,103 @@
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The current chunk corpus format version, bumped whenever the layout changes.
+ * @details open_chunk_corpus() rejects corpora of any other version.
+ */
+inline constexpr uint16_t CHUNK_CORPUS_VERSION = 1;
+
+/**
+ * @brief Bits each cell's hit points are packed into in a chunk corpus.
+ */
+inline constexpr int CORPUS_BITS_PER_CELL = 2;
+
+static_assert(MAX_BLOCK_HP < (1 << CORPUS_BITS_PER_CELL), "Corpus cells must fit a block's hit points");
+static_assert(NUM_COLS * CORPUS_BITS_PER_CELL <= 64, "A corpus row must fit in a single 64-bit word");
+
+/**
+ * @brief A CorpusEntry is a chunk to write into a chunk corpus, with the pattern that generated it (kept for vetting).
+ */
+struct CorpusEntry {
+    PatternKind pattern;
+    Chunk chunk;
+};
+
+/**
+ * @brief Write a set of chunks into a chunk corpus file.
+ * @details Layout (native byte order, every section 8 byte aligned): a header ("BRKC", version, grid dimensions, chunk count),
+ * the size table (first chunk and chunk count of each number of rows, 1 to NUM_ROWS), the index (each chunk's data offset,
+ * pattern and rows), then the chunk data. Chunks are sorted by rows so each size is one run of the index, and each row of a chunk
+ * is one 64-bit word of CORPUS_BITS_PER_CELL bit hit points, column 0 in the low bits.
+ * Chunks of 0 or more than NUM_ROWS rows are skipped.
+ *
+ * @param entries The chunks.
+ * @param path The file path.
+ * @return true If the file was written.
+ */
+bool save_chunk_corpus(const std::vector<CorpusEntry>& entries, const std::string& path);
+
+/**
+ * @brief Open a chunk corpus file written by save_chunk_corpus().
+ * @details The file is memory-mapped read only (read into memory on platforms without mmap) and checked up front,
+ * so drawing chunks from it never has to. The corpus is left closed if the file is invalid.
+ * The whole file is hashed into corpus.hash, which snapshots use to tell corpora apart.
+ *
+ * @param corpus The corpus to open into (from new_chunk_corpus()), closed first.
+ * @param path The file path.
+ * @return true If the corpus was opened.
+ * @return false If the file can't be read, is truncated, has the wrong magic, version or grid dimensions,
+ * or its size table or index point outside the file.
+ */
+bool open_chunk_corpus(ChunkCorpus& corpus, const std::string& path);
+
+/**
+ * @brief Close a chunk corpus, unmapping its file.
+ *
+ * @param corpus The corpus.
+ */
+void close_chunk_corpus(ChunkCorpus& corpus);
+
+/**
+ * @brief Get the number of chunks of a size in a chunk corpus.
+ *
+ * @param corpus The corpus.
+ * @param rows The number of rows.
+ * @return uint32_t The number of chunks with that many rows (0 for sizes outside [1, NUM_ROWS]).
+ */
+uint32_t corpus_count(const ChunkCorpus& corpus, int rows);
+
+/**
+ * @brief Get the pattern that generated a chunk of a chunk corpus.
+ *
+ * @param corpus The corpus.
+ * @param i The chunk's index, less than corpus.num_chunks.
+ * @return PatternKind The pattern.
+ */
+PatternKind corpus_pattern(const ChunkCorpus& corpus, uint32_t i);
+
+/**
+ * @brief Unpack a chunk of a chunk corpus.
+ * @details Reads the chunk's rows straight out of the mapped file, one word per row.
+ *
+ * @param corpus The corpus.
+ * @param i The chunk's index, less than corpus.num_chunks.
+ * @param out The chunk to unpack into, its storage is reused.
+ */
+void corpus_chunk(const ChunkCorpus& corpus, uint32_t i, Chunk& out);
+
+/**
+ * @brief Unpack a random chunk of a size from a chunk corpus.
+ *
+ * @param corpus The corpus.
+ * @param rows The number of rows.
+ * @param rng The random number generator to pick the chunk with.
+ * @param out The chunk to unpack into.
+ * @return true If the corpus has a chunk of that size.
+ * @return false If it doesn't, out is left untouched and nothing is drawn from the rng.
+ */
+bool random_corpus_chunk(const ChunkCorpus& corpus, int rows, XOR& rng, Chunk& out);
@@ -1,25 +1,32 @@
+#pragma once
+
 #include "types.h"
+#include "renderer.h"
 
 /**
  * @brief Draw the global state of the game.
  * @param g The game state.
+ * @param r The renderer to draw with.
  */
-void draw_global_state(const GameState& g);
+void draw_global_state(const GameState& g, Renderer& r);
 
 
 /**
- * @brief Draw the block.
+ * @brief Draw the block in a cell, coloured by its hit points.
  *
- * @param b The block to draw.
+ * @param g The game state.
+ * @param cell The grid position of the block.
+ * @param r The renderer to draw with.
  */
-void block_draw(const Block& b);
+void block_draw(const GameState& g, ivec2 cell, Renderer& r);
 
 /**
  * @brief Draw the terrain in the game.
  *
  * @param g The game state.
+ * @param r The renderer to draw with.
  */
-void draw_terrain(const GameState& g);
+void draw_terrain(const GameState& g, Renderer& r);
 
 
 
@@ -27,22 +34,25 @@ void draw_terrain(const GameState& g);
  * @brief Draw the ball.
  *
  * @param b The ball to draw.
+ * @param r The renderer to draw with.
  */
-void ball_draw(const Ball& b);
+void ball_draw(const Ball& b, Renderer& r);
 
 /**
  * @brief Draw the balls in the game.
  *
  * @param g The game state.
+ * @param r The renderer to draw with.
  */
-void draw_balls(const GameState& g);
+void draw_balls(const GameState& g, Renderer& r);
 
 /**
- * @brief Draw the ball's trail.
+ * @brief Draw the ball's trail as a ribbon tapering and fading from the ball to the oldest position.
  *
  * @param b The ball to draw the trail for.
+ * @param r The renderer to draw with.
  */
-void trail_draw(const Ball& b);
+void trail_draw(const Ball& b, Renderer& r);
 
 
 
@@ -50,21 +60,43 @@ void trail_draw(const Ball& b);
  * @brief Draw the paddle.
  *
  * @param g The game state.
+ * @param r The renderer to draw with.
+ */
+void paddle_draw(const GameState& g, Renderer& r);
+
+
+
+/**
+ * @brief Draw the powerup.
+ *
+ * @param p The powerup to draw.
+ * @param r The renderer to draw with.
+ */
+void powerup_draw(const PowerUp& p, Renderer& r);
+
+/**
+ * @brief Draw the powerups in the game, along with their shared trail.
+ *
+ * @param g The game state.
+ * @param r The renderer to draw with.
  */
-void paddle_draw(const GameState& g);
+void draw_powerups(const GameState& g, Renderer& r);
 
 
 
 /**
- * @brief Draw the particle.
+ * @brief Draw the particle, faded and shrunk by how much of its ttl has lapsed.
  *
  * @param p The particle to draw.
+ * @param now The current tick.
+ * @param r The renderer to draw with.
  */
-void particle_draw(const Particle& p);
+void particle_draw(const Particle& p, uint32_t now, Renderer& r);
 
 /**
  * @brief Draw the particles in the game.
  *
  * @param g The game state.
+ * @param r The renderer to draw with.
  */
-void draw_particles(const GameState& g);
+void draw_particles(const GameState& g, Renderer& r);
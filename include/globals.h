@@ -35,6 +35,7 @@ inline constexpr int TERRAIN_HEIGHT = TERRAIN_WIDTH;
  */
 inline constexpr int NUM_ROWS = 50;
 inline constexpr int NUM_COLS = 25;
+inline constexpr int NUM_CELLS = NUM_ROWS * NUM_COLS;
 
 /**
  * @brief The global block dimensions inside the Terrain Grid.
@@ -44,17 +45,70 @@ inline constexpr int BLOCK_WIDTH = TERRAIN_WIDTH / NUM_COLS;
 inline constexpr int BLOCK_HEIGHT = TERRAIN_HEIGHT / NUM_ROWS;
 
 inline constexpr float BLOCK_POWERUP_CHANCE = 0.02;
+inline constexpr int MAX_BLOCK_HP = 3;
+inline constexpr int EXPLOSION_RADIUS = 4;
+inline constexpr int ACID_RADIUS = 1;
+inline constexpr int ACID_CELLS_PER_TICK = 8;
+inline constexpr float EXPLOSIVE_BLOCK_CHANCE = 0.03;
+inline constexpr int EXPLOSIVE_BLOCK_RADIUS = 2;
+inline constexpr int EXPLOSIONS_PER_TICK = 2;
 inline constexpr int INITIAL_PADDLE_WIDTH = WINDOW_WIDTH / 10;
 inline constexpr int MAX_PADDLE_WIDTH = INITIAL_PADDLE_WIDTH * 2;
 inline constexpr int MIN_PADDLE_WIDTH = INITIAL_PADDLE_WIDTH / 2;
 
+/**
+ * @brief Powerup limits and motion.
+ *
+ */
+inline constexpr uint32_t MAX_POWERUPS = 32;
+inline constexpr uint32_t POWERUP_TRAIL_CAPACITY = 256;
+
+/**
+ * @brief The number of slots (ticks ahead) of the timer wheels particles and balls expire through.
+ * @details Enough for every particle and ball lifetime without going round the wheel, longer ones still work.
+ *
+ */
+inline constexpr uint32_t PARTICLE_TIMER_SLOTS = 128;
+inline constexpr uint32_t BALL_TIMER_SLOTS = 1024;
+inline constexpr int POWERUP_SIZE = 6;
+inline constexpr float POWERUP_GRAVITY = 0.05;
+inline constexpr float POWERUP_MAX_FALL_SPEED = 4;
+inline constexpr float PADDLE_WIDEN_FACTOR = 1.25;
+inline constexpr float PADDLE_SHRINK_FACTOR = 0.8;
+
+/**
+ * @brief The lowest cosmetic quality level the quality governor goes down to.
+ *
+ */
+inline constexpr float MIN_QUALITY = 0.1;
+
+/**
+ * @brief How particles bounce off terrain: the fraction of speed kept into the surface, the fraction kept along it,
+ * and the bounce speed below which a particle comes to rest.
+ *
+ */
+inline constexpr float PARTICLE_RESTITUTION = 0.4;
+inline constexpr float PARTICLE_FRICTION = 0.7;
+inline constexpr float PARTICLE_SETTLE_SPEED = 0.3;
 
-// rng
 /**
- * @brief The global random number generator.
+ * @brief The number of past positions a ball keeps for its trail, and how far apart (in pixels) they are recorded.
  *
  */
-inline XOR rng = XOR();
+inline constexpr uint32_t BALL_TRAIL_LENGTH = 8;
+inline constexpr double BALL_TRAIL_SPACING = 6;
+
+/**
+ * @brief The size (in pixels) of a cell of the ball grid, the spatial hash ball-ball collisions are found with,
+ * and the grid's dimensions, covering the game area.
+ * @details A cell fits a couple of balls side by side, so most balls only have their own and the 8 neighbouring cells to check.
+ *
+ */
+inline constexpr int BALL_GRID_CELL_SIZE = 16;
+inline constexpr int BALL_GRID_COLS = GAME_AREA_WIDTH / BALL_GRID_CELL_SIZE + 1;
+inline constexpr int BALL_GRID_ROWS = GAME_AREA_HEIGHT / BALL_GRID_CELL_SIZE + 1;
+inline constexpr int BALL_GRID_CELLS = BALL_GRID_COLS * BALL_GRID_ROWS;
+
 
 /**
  * @brief The game palette.
@@ -63,7 +117,13 @@ inline XOR rng = XOR();
 const color clr_background = color_from_hex("#000000");
 const color clr_paddle = color_from_hex("#FBF6E0");
 const color clr_block = color_from_hex("#FBF6E0");
+const color clr_block_tough = color_from_hex("#C9BC94");
+const color clr_block_hard = color_from_hex("#8F8262");
+const color clr_block_explosive = color_from_hex("#FF7A3D");
 const color clr_ball_standard = color_from_hex("#FBF6E0");
 const color clr_ball_explosion = color_from_hex("#FF2727");
 const color clr_ball_acid = color_from_hex("#AFFF26");
+const color clr_powerup_widen = color_from_hex("#26C9FF");
+const color clr_powerup_shrink = color_from_hex("#FF9F26");
+const color clr_powerup_multiball = color_from_hex("#D726FF");
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "occupancy.h"
+#include <cstdint>
+
+/**
+ * @brief A NoiseParams is the settings of a fractal value noise field over the terrain cells.
+ * @details The field sums octaves of value noise (random values on a lattice, smoothly interpolated between), each octave
+ * at twice the frequency of the one before and persistence times its weight, normalised back to [0, 1].
+ * The seed picks the field, and the frequencies (lattice points per cell) how large its features are along each axis.
+ * Ridged noise folds every octave as 1 - |2n - 1|, so the field peaks along thin winding lines instead of in blobs.
+ */
+struct NoiseParams {
+    uint32_t seed;
+    float frequency_x;
+    float frequency_y;
+    int octaves;
+    float persistence;
+    bool ridged;
+};
+
+/**
+ * @brief Evaluate a noise field along a row of cells.
+ * @details The row is evaluated 4 cells at a time with SSE2 where available (define NOISE_NO_SIMD to turn it off),
+ * giving the same values as the scalar fallback. Rows can be any length, the field isn't tied to the terrain size.
+ *
+ * @param p The noise field.
+ * @param row The row.
+ * @param out Output value of each cell, in [0, 1].
+ * @param count The number of cells, starting at column 0.
+ */
+void noise_row(const NoiseParams& p, int row, float* out, int count);
+
+/**
+ * @brief Get the mask of the values above a threshold.
+ *
+ * @param values The values of a row, from column 0.
+ * @param count The number of values (at most NUM_COLS).
+ * @param threshold The threshold.
+ * @return RowBits The mask with bit x set when values[x] > threshold.
+ */
+RowBits threshold_mask(const float* values, int count, float threshold);
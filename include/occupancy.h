@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "globals.h"
+
+/**
+ * @brief A RowBits is a bitmask of the cells in a single terrain row.
+ * @details Bit x is set when column x of the row holds an active block.
+ * NUM_COLS fits in a single 32-bit word so whole-row queries (empty checks, counts, masks)
+ * are single word operations instead of loops over the cells.
+ */
+using RowBits = uint32_t;
+
+static_assert(NUM_COLS <= 32, "A terrain row must fit in a single RowBits word");
+
+/**
+ * @brief An Occupancy is a bitboard of the whole terrain, one RowBits word per row.
+ */
+using Occupancy = std::array<RowBits, NUM_ROWS>;
+
+/**
+ * @brief Mask with a bit set for every column in the terrain.
+ *
+ */
+inline constexpr RowBits FULL_ROW = NUM_COLS == 32 ? ~RowBits(0) : (RowBits(1) << NUM_COLS) - 1;
+
+/**
+ * @brief Get the mask for a single cell.
+ *
+ * @param col The column of the cell.
+ * @return RowBits The mask with only bit col set.
+ */
+inline RowBits cell_bit(int col) {
+    return RowBits(1) << col;
+}
+
+/**
+ * @brief Get the index of a cell in the per-cell terrain arrays (row-major).
+ *
+ * @param col The column of the cell.
+ * @param row The row of the cell.
+ * @return int The index.
+ */
+inline int cell_index(int col, int row) {
+    return row * NUM_COLS + col;
+}
+
+/**
+ * @brief Get the mask for columns [first, last], clipped to the terrain.
+ *
+ * @param first The first column of the span.
+ * @param last The last column of the span (inclusive).
+ * @return RowBits The span mask (0 if the span is entirely off the terrain).
+ */
+inline RowBits span_mask(int first, int last) {
+    first = first < 0 ? 0 : first;
+    last = last >= NUM_COLS ? NUM_COLS - 1 : last;
+    if (first > last) return 0;
+    RowBits upto_last = last == 31 ? ~RowBits(0) : (RowBits(1) << (last + 1)) - 1;
+    return upto_last & ~((RowBits(1) << first) - 1);
+}
+
+/**
+ * @brief Count the set cells in a row.
+ *
+ * @param bits The row mask.
+ * @return int The number of set bits.
+ */
+inline int bit_count(RowBits bits) {
+    return __builtin_popcount(bits);
+}
+
+/**
+ * @brief Get the column of the lowest set cell in a row.
+ * @details Used with `bits &= bits - 1` to walk the set bits of a row.
+ *
+ * @param bits The row mask, must be non-zero.
+ * @return int The column of the lowest set bit.
+ */
+inline int lowest_bit(RowBits bits) {
+    return __builtin_ctz(bits);
+}
+
+/**
+ * @brief Flood fill a seed mask horizontally through the occupied cells of a row.
+ *
+ * @param seed The cells already known to be reachable.
+ * @param occupied The occupied cells of the row.
+ * @return RowBits Every occupied cell connected to the seed along the row.
+ */
+inline RowBits fill_row(RowBits seed, RowBits occupied) {
+    seed &= occupied;
+    RowBits prev;
+    do {
+        prev = seed;
+        seed |= ((seed << 1) | (seed >> 1)) & occupied;
+    } while (seed != prev);
+    return seed;
+}
+
+/**
+ * @brief Check whether a screen position falls in a set cell of a bitboard.
+ * @details Positions off the terrain are never set. Branch free, a couple of multiplies and one row load,
+ * so it can run for every particle every tick.
+ *
+ * @param bits The bitboard.
+ * @param x The screen x position.
+ * @param y The screen y position.
+ * @return true If the cell under the position is set.
+ */
+inline bool cell_at(const Occupancy& bits, double x, double y) {
+    double fx = (x - TERRAIN_OFFSET) * (1.0 / BLOCK_WIDTH);
+    double fy = y * (1.0 / BLOCK_HEIGHT);
+    // truncation rounds (-1, 0) to 0, the sign checks keep those off the terrain
+    unsigned col = static_cast<unsigned>(static_cast<int>(fx));
+    unsigned row = static_cast<unsigned>(static_cast<int>(fy));
+    bool inside = (fx >= 0) & (fy >= 0) & (col < NUM_COLS) & (row < NUM_ROWS);
+    return inside & (bits[inside ? row : 0] >> (col & 31) & 1);
+}
+
+/**
+ * @brief Get the occupied cells of a row that have an empty neighbour, diagonals included.
+ * @details Diagonals count because a ball crossing a corner enters the diagonal cell directly.
+ * Columns off either end of the row count as empty.
+ *
+ * @param above The occupied cells of the row above.
+ * @param row The occupied cells of the row.
+ * @param below The occupied cells of the row below.
+ * @return RowBits The exposed cells of the row.
+ */
+inline RowBits exposed_cells(RowBits above, RowBits row, RowBits below) {
+    RowBits around = above & below;
+    RowBits interior = around & (around << 1) & (around >> 1) & (row << 1) & (row >> 1);
+    return row & ~interior;
+}
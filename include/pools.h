@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A Handle is a stable reference to an item in a SlotMap.
+ * @details The index names a slot and the generation is bumped every time the slot is freed,
+ * so a handle to a removed item never resolves to whatever reuses its slot.
+ */
+struct Handle {
+    uint32_t index;
+    uint32_t generation;
+};
+
+/**
+ * @brief A handle that never resolves.
+ *
+ */
+inline constexpr Handle NULL_HANDLE = {UINT32_MAX, 0};
+
+/**
+ * @brief Slot map of items addressed by generational handles.
+ * @details Items are stored densely (iterate with begin() / end() or index with [0, size())) and a handle resolves
+ * through its slot to the item's current dense index, so handles stay valid while items move around underneath them.
+ * remove() moves the last item into the hole, so it is O(1); remove_if() keeps the survivors in order.
+ * Storage grows on demand and is kept by clear(), so reserve() up front to never allocate.
+ * sort() keeps its scratch buffers between calls, so it only allocates the first time the map is sorted at a new size.
+ * @tparam T The item type.
+ */
+template<typename T>
+struct SlotMap {
+    /**
+     * @brief Adds an item.
+     * @param item The item to add.
+     * @return The handle of the new item.
+     */
+    inline Handle insert(T item);
+
+    /**
+     * @brief Looks up an item by handle.
+     * @param h The handle.
+     * @return A pointer to the item, or nullptr if the item has been removed.
+     */
+    inline T* get(Handle h);
+    inline const T* get(Handle h) const;
+
+    /**
+     * @brief Removes an item by handle.
+     * @param h The handle.
+     * @return true if the item was live and has been removed.
+     */
+    inline bool remove(Handle h);
+
+    /**
+     * @brief Removes the item at a dense index. The last item moves into its place.
+     * @param i The dense index, in [0, size()).
+     */
+    inline void remove_at(uint32_t i);
+
+    /**
+     * @brief Removes every item matching a predicate, keeping the order of the rest.
+     * @param pred The predicate, called once per item.
+     * @return The number of items removed.
+     */
+    template<typename Pred>
+    inline uint32_t remove_if(Pred pred);
+
+    /**
+     * @brief Stable sorts the items. Handles stay valid.
+     * @param less The ordering.
+     */
+    template<typename Less>
+    inline void sort(Less less);
+
+    /**
+     * @brief Gets the handle of the item at a dense index.
+     * @param i The dense index, in [0, size()).
+     * @return The item's handle.
+     */
+    inline Handle handle_at(uint32_t i) const;
+
+    /**
+     * @brief Removes every item, invalidating all handles.
+     */
+    inline void clear();
+
+    /**
+     * @brief Makes room for a number of items, so inserting up to that many doesn't allocate.
+     * @param n The number of items.
+     */
+    inline void reserve(uint32_t n);
+
+    inline uint32_t size() const { return static_cast<uint32_t>(items.size()); }
+    inline bool empty() const { return items.empty(); }
+    inline T& operator[](uint32_t i) { return items[i]; }
+    inline const T& operator[](uint32_t i) const { return items[i]; }
+    inline T* begin() { return items.data(); }
+    inline T* end() { return items.data() + items.size(); }
+    inline const T* begin() const { return items.data(); }
+    inline const T* end() const { return items.data() + items.size(); }
+
+private:
+    inline void free_slot(uint32_t slot);
+
+    std::vector<T> items; ///< The live items, densely packed.
+    std::vector<uint32_t> item_slot; ///< The slot of each dense item.
+    std::vector<uint32_t> slot_item; ///< The dense index of each slot's item.
+    std::vector<uint32_t> generations; ///< The current generation of each slot.
+    std::vector<uint32_t> free_slots; ///< Stack of unused slots.
+    std::vector<uint32_t> sort_order, sort_merged; ///< sort() scratch, the dense indices in sorted order.
+    std::vector<T> sort_items; ///< sort() scratch, the items in sorted order.
+    std::vector<uint32_t> sort_slots; ///< sort() scratch, the slots of the items in sorted order.
+};
+
+/**
+ * @brief Fixed-capacity ring of items where pushing onto a full ring overwrites the oldest item.
+ * @tparam T The item type.
+ * @tparam Capacity The number of items kept.
+ */
+template<typename T, uint32_t Capacity>
+struct Ring {
+    /**
+     * @brief Constructor for an empty ring.
+     */
+    Ring() : head(0), count(0) {}
+
+    /**
+     * @brief Adds an item, overwriting the oldest if the ring is full.
+     * @param item The item to add.
+     */
+    inline void push(const T& item);
+
+    /**
+     * @brief Drops the oldest item.
+     */
+    inline void pop_oldest();
+
+    /**
+     * @brief Gets an item by age.
+     * @param i The position from the oldest item, in [0, size()).
+     * @return The item.
+     */
+    inline T& operator[](uint32_t i) { return items[(head + i) % Capacity]; }
+    inline const T& operator[](uint32_t i) const { return items[(head + i) % Capacity]; }
+
+    inline void clear() { head = 0; count = 0; }
+    inline uint32_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+
+private:
+    std::array<T, Capacity> items;
+    uint32_t head; ///< The position of the oldest item.
+    uint32_t count; ///< The number of items.
+};
+
+/**
+ * @brief Timer wheel of handles, each due to fire at a tick.
+ * @details A handle due at tick t waits in slot t % Slots, and expire() only takes the current tick's slot,
+ * so each tick touches the handles due then and nothing else. Handles due Slots or more ticks out wait in the furthest
+ * slot and are scheduled again when it comes round. expire() has to be called for every tick, in order.
+ * The wheel doesn't know what its handles refer to, check them before use (a removed item's handle doesn't resolve).
+ * @tparam Slots The number of slots, the furthest ahead a handle fires without being scheduled again.
+ */
+template<uint32_t Slots>
+struct TimerWheel {
+    /**
+     * @brief Schedules a handle.
+     * @param h The handle.
+     * @param due The tick to fire at, handles already due fire on the next tick.
+     * @param now The current tick.
+     */
+    inline void schedule(Handle h, uint32_t due, uint32_t now);
+
+    /**
+     * @brief Fires the handles due at the current tick.
+     * @param now The current tick.
+     * @param fire Called with each handle due.
+     */
+    template<typename Fire>
+    inline void expire(uint32_t now, Fire fire);
+
+    inline void clear();
+
+private:
+    struct Timer {
+        Handle handle;
+        uint32_t due;
+    };
+    std::array<std::vector<Timer>, Slots> slots;
+};
+
+// Inline function definitions
+
+template<typename T>
+inline Handle SlotMap<T>::insert(T item) {
+    uint32_t slot;
+    if (free_slots.empty()) {
+        slot = static_cast<uint32_t>(slot_item.size());
+        slot_item.push_back(0);
+        generations.push_back(0);
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    slot_item[slot] = size();
+    items.push_back(std::move(item));
+    item_slot.push_back(slot);
+    return {slot, generations[slot]};
+}
+
+template<typename T>
+inline T* SlotMap<T>::get(Handle h) {
+    if (h.index >= generations.size() || generations[h.index] != h.generation) {
+        return nullptr;
+    }
+    return &items[slot_item[h.index]];
+}
+
+template<typename T>
+inline const T* SlotMap<T>::get(Handle h) const {
+    return const_cast<SlotMap*>(this)->get(h);
+}
+
+template<typename T>
+inline bool SlotMap<T>::remove(Handle h) {
+    if (!get(h)) {
+        return false;
+    }
+    remove_at(slot_item[h.index]);
+    return true;
+}
+
+template<typename T>
+inline void SlotMap<T>::remove_at(uint32_t i) {
+    free_slot(item_slot[i]);
+    uint32_t last = size() - 1;
+    if (i != last) {
+        items[i] = std::move(items[last]);
+        item_slot[i] = item_slot[last];
+        slot_item[item_slot[i]] = i;
+    }
+    items.pop_back();
+    item_slot.pop_back();
+}
+
+template<typename T>
+template<typename Pred>
+inline uint32_t SlotMap<T>::remove_if(Pred pred) {
+    uint32_t kept = 0;
+    uint32_t n = size();
+    for (uint32_t i = 0; i < n; ++i) {
+        if (pred(items[i])) {
+            free_slot(item_slot[i]);
+            continue;
+        }
+        if (kept != i) {
+            items[kept] = std::move(items[i]);
+            item_slot[kept] = item_slot[i];
+        }
+        slot_item[item_slot[kept]] = kept;
+        ++kept;
+    }
+    items.erase(items.begin() + kept, items.end());
+    item_slot.resize(kept);
+    return n - kept;
+}
+
+template<typename T>
+template<typename Less>
+inline void SlotMap<T>::sort(Less less) {
+    uint32_t n = size();
+    sort_order.resize(n);
+    sort_merged.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        sort_order[i] = i;
+    }
+    // bottom-up merge sort of the dense indices, ties keep the earlier run first so it is stable
+    for (uint32_t width = 1; width < n; width *= 2) {
+        for (uint32_t first = 0; first < n; first += 2 * width) {
+            uint32_t mid = std::min(first + width, n);
+            uint32_t last = std::min(first + 2 * width, n);
+            uint32_t l = first, r = mid, out = first;
+            while (l < mid && r < last) {
+                sort_merged[out++] = less(items[sort_order[r]], items[sort_order[l]]) ? sort_order[r++] : sort_order[l++];
+            }
+            while (l < mid) sort_merged[out++] = sort_order[l++];
+            while (r < last) sort_merged[out++] = sort_order[r++];
+        }
+        sort_order.swap(sort_merged);
+    }
+
+    sort_items.clear();
+    sort_items.reserve(n);
+    sort_slots.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        sort_items.push_back(std::move(items[sort_order[i]]));
+        sort_slots[i] = item_slot[sort_order[i]];
+        slot_item[sort_slots[i]] = i;
+    }
+    // the old storage becomes the scratch for the next sort
+    items.swap(sort_items);
+    item_slot.swap(sort_slots);
+    sort_items.clear();
+}
+
+template<typename T>
+inline Handle SlotMap<T>::handle_at(uint32_t i) const {
+    return {item_slot[i], generations[item_slot[i]]};
+}
+
+template<typename T>
+inline void SlotMap<T>::clear() {
+    for (uint32_t slot : item_slot) {
+        free_slot(slot);
+    }
+    items.clear();
+    item_slot.clear();
+}
+
+template<typename T>
+inline void SlotMap<T>::reserve(uint32_t n) {
+    items.reserve(n);
+    item_slot.reserve(n);
+    slot_item.reserve(n);
+    generations.reserve(n);
+    free_slots.reserve(n);
+}
+
+template<typename T>
+inline void SlotMap<T>::free_slot(uint32_t slot) {
+    ++generations[slot];
+    free_slots.push_back(slot);
+}
+
+template<typename T, uint32_t Capacity>
+inline void Ring<T, Capacity>::push(const T& item) {
+    if (count == Capacity) {
+        items[head] = item;
+        head = (head + 1) % Capacity;
+    } else {
+        items[(head + count) % Capacity] = item;
+        ++count;
+    }
+}
+
+template<typename T, uint32_t Capacity>
+inline void Ring<T, Capacity>::pop_oldest() {
+    if (count == 0) return;
+    head = (head + 1) % Capacity;
+    --count;
+}
+
+template<uint32_t Slots>
+inline void TimerWheel<Slots>::schedule(Handle h, uint32_t due, uint32_t now) {
+    // tick differences are taken signed, so the tick counter can wrap
+    int32_t ahead = std::clamp<int32_t>(static_cast<int32_t>(due - now), 1, Slots - 1);
+    slots[(now + ahead) % Slots].push_back({h, due});
+}
+
+template<uint32_t Slots>
+template<typename Fire>
+inline void TimerWheel<Slots>::expire(uint32_t now, Fire fire) {
+    // scheduling again never lands in the current slot, so the slot can be walked while it happens
+    std::vector<Timer>& slot = slots[now % Slots];
+    for (size_t i = 0; i < slot.size(); ++i) {
+        Timer timer = slot[i];
+        if (static_cast<int32_t>(timer.due - now) <= 0) {
+            fire(timer.handle);
+        } else {
+            schedule(timer.handle, timer.due, now);
+        }
+    }
+    slot.clear();
+}
+
+template<uint32_t Slots>
+inline void TimerWheel<Slots>::clear() {
+    for (auto& slot : slots) {
+        slot.clear();
+    }
+}
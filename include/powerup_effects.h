@@ -1,3 +1,36 @@
+#pragma once
 
+#include "types.h"
 
-using PowerUpEffect = void
+/**
+ * @brief A PowerUpEffect is a function pointer that is used to represent the effect of a powerup.
+ * @details A PowerUpEffect takes the game state and is called once, when the paddle catches the powerup.
+ * Powerups don't hold the function pointer themselves, they hold a PowerUpKind indexing the POWERUP_EFFECTS table.
+ */
+using PowerUpEffect = void (*)(GameState& game);
+
+// powerup effect functions
+/**
+ * @brief Powerup effect function that is used to represent the effect of a powerup when
+ * the paddle catches it.
+ *
+ * @param g The game state.
+ */
+void powerup_widen(GameState& g);
+void powerup_shrink(GameState& g);
+void powerup_multiball(GameState& g);
+
+/**
+ * @brief The powerup effect functions, indexed by PowerUpKind.
+ *
+ */
+inline constexpr PowerUpEffect POWERUP_EFFECTS[NUM_POWERUP_KINDS] = {powerup_widen, powerup_shrink, powerup_multiball};
+
+// util
+/**
+ * @brief Generate a powerup with a randomly selected kind.
+ *
+ * @param rng The random number generator to roll with.
+ * @return PowerUp The generated powerup.
+ */
+PowerUp roll_powerup(XOR& rng);
@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * @brief A QualityGovernor picks the cosmetic quality level (GameState::quality) from measured frame times.
+ * @details Frame times are smoothed, and the level only moves after the smoothed time has stayed outside a dead band
+ * for a while: it drops quickly once frames run over budget and climbs back slowly once they are comfortably under,
+ * so it doesn't flicker between levels. After each change it waits for the smoothed time to catch up before judging again.
+ * Only emission is scaled, so gameplay is the same at any level.
+ */
+struct QualityGovernor {
+    double budget_us;
+    double smoothed_us;
+    float level;
+    int frames_over;
+    int frames_under;
+    int cooldown;
+};
+
+/**
+ * @brief Create a new quality governor, starting at full quality.
+ *
+ * @param budget_us The frame time to stay under, in microseconds.
+ * @return QualityGovernor The new governor.
+ */
+QualityGovernor new_quality_governor(double budget_us);
+
+/**
+ * @brief Feed a frame time to the governor.
+ *
+ * @param q The governor.
+ * @param frame_us The time the last frame took, in microseconds.
+ * @return float The quality level to use, in [MIN_QUALITY, 1].
+ */
+float update_quality_governor(QualityGovernor& q, double frame_us);
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "types.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A RenderBackend is where a renderer's draw calls end up.
+ * @details WINDOW draws to the SplashKit window, SOFTWARE rasterizes into an in-memory framebuffer
+ * so frames can be timed, hashed and saved without a display (headless benchmarks and golden-frame checks),
+ * and RECORD appends the calls to a RenderFrame to be replayed later (on another thread).
+ */
+enum RenderBackend {
+    RENDER_WINDOW,
+    RENDER_SOFTWARE,
+    RENDER_RECORD
+};
+
+/**
+ * @brief A RenderPass is one of the groups of draw calls draw_global_state() makes, timed separately.
+ *
+ */
+enum RenderPass {
+    PASS_BACKGROUND,
+    PASS_PARTICLES,
+    PASS_TERRAIN,
+    PASS_POWERUPS,
+    PASS_PADDLE,
+    PASS_BALLS,
+    NUM_RENDER_PASSES
+};
+
+/**
+ * @brief A Framebuffer is an RGBA8 image, one uint32_t per pixel with red in the lowest byte, rows top to bottom.
+ *
+ */
+struct Framebuffer {
+    int width;
+    int height;
+    std::vector<uint32_t> pixels;
+};
+
+/**
+ * @brief A RenderCommandKind identifies the draw call a RenderCommand records.
+ *
+ */
+enum RenderCommandKind : uint8_t {
+    COMMAND_CLEAR,
+    COMMAND_RECT,
+    COMMAND_CIRCLE,
+    COMMAND_TEXT,
+    COMMAND_RIBBON
+};
+
+/**
+ * @brief A RibbonPoint is one point along the centre line of a ribbon, with the ribbon's half width
+ * and opacity (multiplied with the colour's alpha) there.
+ *
+ */
+struct RibbonPoint {
+    float x, y;
+    float half_width;
+    float alpha;
+};
+
+/**
+ * @brief A RenderCommand is one recorded draw call.
+ * @details Rects use x, y, w, h, circles use x, y and w as the radius, text uses x, y and data as the index
+ * into the frame's strings, and ribbons use data as the index of their first point in the frame's ribbon points
+ * and w as the point count.
+ */
+struct RenderCommand {
+    RenderCommandKind kind;
+    color clr;
+    float x, y, w, h;
+    uint32_t data;
+};
+
+/**
+ * @brief A RenderFrame is a recorded frame, everything needed to draw it without the game state.
+ * @details Once published a frame is immutable, so the thread drawing it never shares data with the simulation.
+ * Clearing a frame keeps its capacity, so a reused frame stops allocating.
+ * The commands each pass recorded are [pass_begin[pass], pass_end[pass]), so one pass can be replayed on its own
+ * (the paddle is redrawn at the latest mouse position this way).
+ * The paddle command is the index of the paddle's rect, marked with render_mark_paddle(), or NO_COMMAND if none was drawn.
+ */
+struct RenderFrame {
+    std::vector<RenderCommand> commands;
+    std::vector<std::string> text;
+    std::vector<RibbonPoint> ribbon_points;
+    uint32_t pass_begin[NUM_RENDER_PASSES];
+    uint32_t pass_end[NUM_RENDER_PASSES];
+    uint32_t paddle_command;
+};
+
+/**
+ * @brief A command index that names no command.
+ *
+ */
+inline constexpr uint32_t NO_COMMAND = UINT32_MAX;
+
+/**
+ * @brief A Renderer is the target of the draw functions (draw.cpp).
+ * @details The framebuffer is only used by the software backend and the frame by the record backend.
+ * The pass timings and draw call count accumulate until reset_render_stats(), so benchmarks can average them over frames.
+ * The draw call count is the calls issued to the backend, a ribbon counts one per quad unless it is recorded.
+ * The software backend skips text.
+ */
+struct Renderer {
+    RenderBackend backend;
+    Framebuffer framebuffer;
+    RenderFrame* frame;
+    double pass_us[NUM_RENDER_PASSES];
+    long draw_calls;
+    int frames;
+    RenderPass current_pass;
+    std::chrono::steady_clock::time_point pass_start;
+};
+
+/**
+ * @brief Create a renderer drawing to the SplashKit window.
+ *
+ * @return Renderer The new renderer.
+ */
+Renderer new_window_renderer();
+
+/**
+ * @brief Create a renderer rasterizing into an in-memory framebuffer.
+ *
+ * @param width The framebuffer width in pixels.
+ * @param height The framebuffer height in pixels.
+ * @return Renderer The new renderer.
+ */
+Renderer new_software_renderer(int width, int height);
+
+/**
+ * @brief Create a renderer recording draw calls into a RenderFrame.
+ * @details Point it at a frame with begin_recording() before drawing.
+ *
+ * @return Renderer The new renderer.
+ */
+Renderer new_recording_renderer();
+
+/**
+ * @brief Clear a frame and direct a recording renderer's draw calls into it.
+ *
+ * @param r The recording renderer.
+ * @param frame The frame to record into.
+ */
+void begin_recording(Renderer& r, RenderFrame& frame);
+
+/**
+ * @brief Draw a recorded frame with another renderer.
+ *
+ * @param frame The recorded frame.
+ * @param r The renderer to draw with.
+ */
+void replay_frame(const RenderFrame& frame, Renderer& r);
+
+/**
+ * @brief Draw a range of a recorded frame's commands with another renderer, optionally moved sideways.
+ * @details The range is clamped to the frame's commands.
+ *
+ * @param frame The recorded frame.
+ * @param begin The first command.
+ * @param end One past the last command.
+ * @param r The renderer to draw with.
+ * @param dx How far to move the commands along x.
+ */
+void replay_commands(const RenderFrame& frame, uint32_t begin, uint32_t end, Renderer& r, double dx = 0);
+
+/**
+ * @brief Clear the whole target to a colour.
+ *
+ * @param r The renderer.
+ * @param c The colour.
+ */
+void render_clear(Renderer& r, color c);
+
+/**
+ * @brief Fill a rectangle, covering the pixels whose centres fall inside it.
+ *
+ * @param r The renderer.
+ * @param c The colour (blended by its alpha).
+ * @param x The left edge.
+ * @param y The top edge.
+ * @param width The width.
+ * @param height The height.
+ */
+void render_fill_rect(Renderer& r, color c, double x, double y, double width, double height);
+
+/**
+ * @brief Fill a circle, covering the pixels whose centres fall inside it.
+ *
+ * @param r The renderer.
+ * @param c The colour (blended by its alpha).
+ * @param x The centre x.
+ * @param y The centre y.
+ * @param radius The radius.
+ */
+void render_fill_circle(Renderer& r, color c, double x, double y, double radius);
+
+/**
+ * @brief Fill a ribbon, a strip following a polyline whose width and opacity vary along it.
+ * @details The strip is made of a quad per segment, with the quads meeting on the bisector at each point
+ * so they cover every pixel once. Each quad takes the mean opacity of its two ends.
+ * The window and software backends draw each quad as its own draw call (SplashKit has no strip or mesh fill),
+ * the record backend records the whole ribbon as one command.
+ *
+ * @param r The renderer.
+ * @param c The colour.
+ * @param points The points along the centre line.
+ * @param count The number of points (nothing is drawn for fewer than 2).
+ */
+void render_fill_ribbon(Renderer& r, color c, const RibbonPoint* points, int count);
+
+/**
+ * @brief Draw text in screen space (skipped by the software backend).
+ *
+ * @param r The renderer.
+ * @param text The text.
+ * @param c The colour.
+ * @param x The left edge.
+ * @param y The top edge.
+ */
+void render_text(Renderer& r, const std::string& text, color c, double x, double y);
+
+/**
+ * @brief Mark the next draw call as the paddle's rect, so a recorded frame can find it to late-latch.
+ * @details Only the record backend keeps the mark, the other backends ignore it.
+ *
+ * @param r The renderer.
+ */
+void render_mark_paddle(Renderer& r);
+
+/**
+ * @brief Start timing a pass.
+ *
+ * @param r The renderer.
+ * @param pass The pass.
+ */
+void render_begin_pass(Renderer& r, RenderPass pass);
+
+/**
+ * @brief Stop timing the current pass, adding its time to the pass total.
+ *
+ * @param r The renderer.
+ */
+void render_end_pass(Renderer& r);
+
+/**
+ * @brief Zero the pass timings, draw call and frame counts.
+ *
+ * @param r The renderer.
+ */
+void reset_render_stats(Renderer& r);
+
+/**
+ * @brief Get the display name of a pass.
+ *
+ * @param pass The pass.
+ * @return const char* The name.
+ */
+const char* render_pass_name(RenderPass pass);
+
+/**
+ * @brief Hash the pixels of a framebuffer (64-bit FNV-1a over the pixel words), for golden-frame comparisons.
+ *
+ * @param fb The framebuffer.
+ * @return uint64_t The hash.
+ */
+uint64_t frame_hash(const Framebuffer& fb);
+
+/**
+ * @brief Save a framebuffer as a binary PPM image (alpha dropped).
+ *
+ * @param fb The framebuffer.
+ * @param path The file path.
+ * @return true If the file was written.
+ */
+bool write_ppm(const Framebuffer& fb, const std::string& path);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The current snapshot format version, bumped whenever the layout changes.
+ * @details load_snapshot() rejects snapshots of any other version.
+ */
+inline constexpr uint16_t SNAPSHOT_VERSION = 11;
+
+/**
+ * @brief Serialise the full game state into a compact binary snapshot.
+ * @details Layout (native byte order): a header ("BRKN", version, grid dimensions, chunk corpus hash or 0 without a corpus)
+ * followed by the game status, score, tick, ball collision toggle, rng streams, paddle, terrain, erosion queue, explosion queue, balls (with their trail positions), particles, powerups and the powerup trail.
+ * The exposed and animating bitboards are derived from the terrain and rebuilt on load, and the particle and ball timers
+ * from the particles' and balls' birth ticks and ttls.
+ * The terrain is bit-packed: occupancy, dying, connectivity dirty, erosion pending, eroded, explosive and explosion pending bitboards,
+ * then only the fields of each occupied or dying block that can't be derived from its grid position (hit points, y position, y velocity).
+ * Queued cells pushed off the bottom of the grid are left out of the erosion and explosion queues, they would only be skipped.
+ * Ball effects and powerup kinds are saved as their ids. Handles into the balls, particles and powerups are not kept across a load.
+ * Snapshots are meant to be taken between updates (not from inside update_global_state()).
+ *
+ * @param g The game state.
+ * @param out The buffer to write to, cleared first but its capacity is reused.
+ */
+void save_snapshot(const GameState& g, std::vector<uint8_t>& out);
+
+/**
+ * @brief Restore the game state from a snapshot written by save_snapshot().
+ * @details The game state is left untouched if the snapshot is invalid.
+ * The game keeps its own chunk corpus (g.corpus), which has to be the one the snapshot was taken with.
+ *
+ * @param g The game state to restore into.
+ * @param data The snapshot bytes.
+ * @param size The number of bytes.
+ * @return true If the snapshot was restored.
+ * @return false If the snapshot is truncated, has the wrong magic, version, grid dimensions or chunk corpus, an unknown game status,
+ * effect or powerup id, more than MAX_POWERUPS powerups, a particle with no ttl, or blocks whose hit points don't match the bitboards.
+ */
+bool load_snapshot(GameState& g, const uint8_t* data, size_t size);
+
+/**
+ * @brief Save a snapshot of the game state to a file (for benchmark scenarios).
+ *
+ * @param g The game state.
+ * @param path The file path.
+ * @return true If the file was written.
+ */
+bool save_snapshot_file(const GameState& g, const std::string& path);
+
+/**
+ * @brief Load a snapshot file written by save_snapshot_file().
+ *
+ * @param g The game state to restore into.
+ * @param path The file path.
+ * @return true If the file was read and restored.
+ */
+bool load_snapshot_file(GameState& g, const std::string& path);
+
+/**
+ * @brief A SnapshotRing is a fixed-size ring of snapshots, used to rewind the game.
+ * @details The frame buffers are kept between pushes, so once the ring has wrapped a push doesn't allocate.
+ */
+struct SnapshotRing {
+    std::vector<std::vector<uint8_t>> frames;
+    int head;
+    int count;
+};
+
+/**
+ * @brief Create a new snapshot ring.
+ *
+ * @param capacity The number of snapshots kept.
+ * @return SnapshotRing The new ring.
+ */
+SnapshotRing new_snapshot_ring(int capacity);
+
+/**
+ * @brief Snapshot the game state into the ring, overwriting the oldest snapshot when full.
+ *
+ * @param ring The snapshot ring.
+ * @param g The game state.
+ */
+void snapshot_ring_push(SnapshotRing& ring, const GameState& g);
+
+/**
+ * @brief Restore the most recent snapshot in the ring and drop it.
+ *
+ * @param ring The snapshot ring.
+ * @param g The game state to restore into.
+ * @return true If a snapshot was restored.
+ * @return false If the ring is empty.
+ */
+bool snapshot_ring_rewind(SnapshotRing& ring, GameState& g);
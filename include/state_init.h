@@ -5,9 +5,18 @@
 /**
  * @brief Create a new game state.
  *
+ * @param seed The seed the game state's random number streams are split from.
  * @return GameState The new game state.
  */
-GameState new_game_state();
+GameState new_game_state(uint32_t seed = 0x77777777);
+
+/**
+ * @brief Split a seed into the per-subsystem random number streams of a game state.
+ *
+ * @param seed The root seed.
+ * @return RngStreams The terrain, gameplay and cosmetic streams.
+ */
+RngStreams new_rng_streams(uint32_t seed);
 
 /**
  * @brief Reset the game state.
@@ -47,17 +56,45 @@ Particle new_particle(point_2d pos, vector_2d vel, color clr, int size, int ttl)
  * @param ttl The time to live of the ball.
  * @return Ball The new ball.
  */
-Ball new_ball(point_2d pos, vector_2d vel, int size, color clr, BallEffect effect, int ttl_type, int ttl);
+Ball new_ball(point_2d pos, vector_2d vel, int size, color clr, BallEffectId effect, int ttl_type, int ttl);
+
+/**
+ * @brief Create a new powerup.
+ *
+ * @param pos The position of the powerup.
+ * @param vel The velocity of the powerup.
+ * @param size The size of the powerup.
+ * @param clr The color of the powerup.
+ * @param kind The kind of the powerup.
+ * @return PowerUp The new powerup.
+ */
+PowerUp new_powerup(point_2d pos, vector_2d vel, int size, color clr, PowerUpKind kind);
+
+/**
+ * @brief Create an empty terrain.
+ *
+ * @return Terrain The new terrain, with no blocks.
+ */
+Terrain new_terrain();
+
+/**
+ * @brief Create an empty chunk.
+ *
+ * @param rows The number of rows in the chunk.
+ * @return Chunk The new chunk, with no blocks.
+ */
+Chunk new_chunk(int rows);
+
+/**
+ * @brief Create a closed chunk corpus, to open with open_chunk_corpus() (chunk_corpus.h).
+ *
+ * @return ChunkCorpus The new chunk corpus.
+ */
+ChunkCorpus new_chunk_corpus();
 
 /**
- * @brief Create a new block.
+ * @brief Create an empty ball grid.
  *
- * @param pos The position of the block.
- * @param target_pos The target position of the block.
- * @param grid_pos The grid position of the block.
- * @param width The width of the block.
- * @param height The height of the block.
- * @param c The color of the block.
- * @return Block The new block.
+ * @return BallGrid The new ball grid.
  */
-Block new_block(point_2d pos, point_2d target_pos, ivec2 grid_pos, int width, int height, color c);
+BallGrid new_ball_grid();
@@ -6,6 +6,7 @@
 // GLOBAL
 /**
  * @brief Update the global state of the game.
+ * @details Each update is a tick, g.tick counts them.
  *
  * @param g The game state.
  */
@@ -14,20 +15,31 @@ void update_global_state(GameState& g);
 
 // BLOCK
 /**
- * @brief Update the block's position.
+ * @brief Update the position of a falling block, or destroy a dying one.
  *
- * @param b The block to update.
  * @param g The game state.
+ * @param cell The grid position of the block.
  */
-void block_update(Block& b, GameState& g);
+void block_update(GameState& g, ivec2 cell);
 
 /**
- * @brief Destroy the block.
+ * @brief Destroy a dying block, scoring it and throwing off its debris.
  *
- * @param b The block to destroy.
  * @param g The game state.
+ * @param cell The grid position of the block.
  */
-void block_destroy(const Block& b, GameState& g);
+void block_destroy(GameState& g, ivec2 cell);
+
+/**
+ * @brief Get the colour of a block.
+ * @details Explosive blocks are always orange, other blocks lighten as they lose hit points (clr_block at the last one).
+ * Dying blocks take the colour of what destroyed them, for their debris: acid coloured if acid ate them.
+ *
+ * @param g The game state.
+ * @param cell The grid position of the block.
+ * @return color The colour.
+ */
+color block_color(const GameState& g, ivec2 cell);
 
 
 //BALL
@@ -71,14 +83,27 @@ void ball_check_block_collision(Ball& b, GameState& g);
 void ball_check_paddle_collision(Ball& b, GameState& g);
 
 /**
- * @brief Update the particles in the ball's trail.
+ * @brief Add the ball's current position to its trail once it is BALL_TRAIL_SPACING from the last one,
+ * dropping the oldest once the trail is full.
  *
  * @param b The ball to update the trail for.
  */
 void trail_update(Ball& b);
 
+/**
+ * @brief Add a ball to the game, born this tick, and schedule it to expire if it lasts a number of updates (ttl type 2).
+ * @details Not for use while update_balls() is iterating the balls, inserting could reallocate under the loop.
+ *
+ * @param g The game state.
+ * @param b The ball.
+ * @return Handle The handle of the new ball.
+ */
+Handle spawn_ball(GameState& g, Ball b);
+
 /**
  * @brief Update the balls in the game.
+ * @details The balls due to expire this tick (through g.ball_timers) are destroyed instead of moving.
+ * After every ball has moved, touching balls bounce off each other (collide_balls(), ball_grid.h).
  *
  * @param g The game state.
  */
@@ -94,9 +119,71 @@ void update_balls(GameState& g);
  */
 void paddle_update(GameState& g);
 
+/**
+ * @brief Get the paddle position the autopilot wants, lining the paddle up under the lowest falling ball.
+ *
+ * @param g The game state.
+ * @return int The target x position of the paddle.
+ */
+int paddle_autopilot_target(const GameState& g);
+
+/**
+ * @brief Resize the paddle about its centre, clamped to [MIN_PADDLE_WIDTH, MAX_PADDLE_WIDTH].
+ *
+ * @param p The paddle to resize.
+ * @param width The new width.
+ */
+void paddle_resize(Paddle& p, int width);
+
+
+
+// POWERUP
+/**
+ * @brief Drop a powerup into the game.
+ * @details The drop is ignored when MAX_POWERUPS are already falling.
+ *
+ * @param g The game state.
+ * @param p The powerup to drop.
+ * @return Handle The handle of the powerup in g.powerups, or NULL_HANDLE if it was dropped.
+ */
+Handle spawn_powerup(GameState& g, const PowerUp& p);
+
+/**
+ * @brief Update the powerup's position and emit its trail.
+ *
+ * @param p The powerup to update.
+ * @param g The game state.
+ */
+void powerup_update(PowerUp& p, GameState& g);
+
+/**
+ * @brief Check if the powerup has been caught by the paddle.
+ *
+ * @param p The powerup to check.
+ * @param paddle The paddle.
+ * @return true If the powerup overlaps the paddle.
+ */
+bool powerup_check_paddle_collision(const PowerUp& p, const Paddle& paddle);
+
+/**
+ * @brief Update the powerups in the game, applying the effect of any the paddle catches.
+ *
+ * @param g The game state.
+ */
+void update_powerups(GameState& g);
+
 
 
 // PARTICLE
+/**
+ * @brief Add a particle to the game, born this tick and scheduled to expire once its ttl is up.
+ *
+ * @param g The game state.
+ * @param p The particle.
+ * @return Handle The handle of the new particle.
+ */
+Handle spawn_particle(GameState& g, Particle p);
+
 /**
  * @brief Update the particle's position.
  *
@@ -105,7 +192,49 @@ void paddle_update(GameState& g);
 void particle_update(Particle& p);
 
 /**
- * @brief Update the particles in the game.
+ * @brief Get how much of a particle's ttl has lapsed.
+ *
+ * @param p The particle.
+ * @param now The current tick.
+ * @return float The lapsed fraction, 0 when the particle is born and 1 when it expires.
+ */
+float particle_lapsed(const Particle& p, uint32_t now);
+
+/**
+ * @brief Scale a particle burst by the game's quality level.
+ * @details The fractional part is kept as a chance (drawn from the cosmetic stream), so small bursts thin out
+ * on average instead of rounding away. Full quality returns the count untouched.
+ *
+ * @param g The game state.
+ * @param count The number of particles at full quality.
+ * @return int The number of particles to emit.
+ */
+int particle_budget(GameState& g, int count);
+
+/**
+ * @brief Scale a particle time to live by the game's quality level, down to half at the lowest quality.
+ *
+ * @param g The game state.
+ * @param ttl The time to live at full quality.
+ * @return int The time to live to use.
+ */
+int particle_ttl(const GameState& g, int ttl);
+
+/**
+ * @brief Bounce a particle off the terrain if its last move took it into a solid cell.
+ * @details The axis to bounce on is whichever single-axis move would have hit, both for a corner.
+ * Particles starting inside a solid cell (spawned in, or buried by a falling block) pass through until they leave it.
+ *
+ * @param p The particle, already moved.
+ * @param old_pos The particle's position before the move.
+ * @param solid The settled terrain cells.
+ */
+void particle_collide_terrain(Particle& p, point_2d old_pos, const Occupancy& solid);
+
+/**
+ * @brief Update the particles in the game, bouncing them off the terrain.
+ * @details The particles due to expire this tick are removed first (through g.particle_timers).
+ * Falling blocks aren't solid yet, their cells are only claimed on arrival.
  *
  * @param g The game state.
  */
@@ -134,31 +263,135 @@ void shift_rows_down(GameState& g, int num_rows_to_shift);
  *
  * @param g The game state.
  * @param num_rows The number of rows in the chunk.
- * @param pattern_func The function to generate the pattern of the chunk.
+ * @param pattern The pattern of the chunk.
+ * Ignored when g.corpus has a chunk of num_rows rows, a random one of those is used instead.
+ */
+void add_new_chunk(GameState& g, int num_rows, PatternKind pattern);
+
+/**
+ * @brief Erode up to ACID_CELLS_PER_TICK cells from the erosion queue.
+ *
+ * @param g The game state.
+ */
+void update_erosion(GameState& g);
+
+/**
+ * @brief Queue the explosion of an explosive block, unless it is already queued.
+ *
+ * @param g The game state.
+ * @param cell The grid position of the block.
+ */
+void queue_explosion(GameState& g, ivec2 cell);
+
+/**
+ * @brief Set off up to EXPLOSIONS_PER_TICK queued explosions, in the order they were queued.
+ * @details Each clears a circle of EXPLOSIVE_BLOCK_RADIUS around its cell, and any explosive blocks it clears
+ * queue explosions of their own behind the ones already waiting.
+ *
+ * @param g The game state.
  */
-void add_new_chunk(GameState& g, int num_rows, std::function<Grid(int, int)> pattern_func);
+void update_explosions(GameState& g);
 
 /**
  * @brief Update the terrain in the game.
+ * @details Only the blocks in the animating and dying bitboards are updated.
  *
  * @param g The game state.
  */
 void update_terrain(GameState& g);
 
 /**
- * @brief Uses dfs_mark_reachable() to check if blocks are not connected to top row (have been shaved off main body of terrain)
+ * @brief Uses mark_reachable() to check if blocks are not connected to top row (have been shaved off main body of terrain)
  * and deactivates them.
+ * @details Only the terrain around cells marked in g.connectivity_dirty is checked, and nothing at all if no cells were removed.
  *
  * @param g The game state.
  */
 void deactivate_disconnected_clusters(GameState& g);
 
 /**
- * @brief Uses DFS to mark blocks that are reachable from the top row.
+ * @brief Mark the whole terrain for the next disconnected-cluster pass (after it changes by more than removals).
+ *
+ * @param g The game state.
+ */
+void invalidate_connectivity(GameState& g);
+
+/**
+ * @brief Flood fills the occupancy bitboard from a seed, one row word at a time.
+ *
+ * @param occupied The occupied cells of the terrain.
+ * @param seed The cells to fill from.
+ * @param filled Output bitboard of the occupied cells connected to the seed.
+ */
+void flood_fill(const Occupancy& occupied, const Occupancy& seed, Occupancy& filled);
+
+/**
+ * @brief Flood fills the occupancy bitboard from the top row, one row word at a time.
+ *
+ * @param occupied The occupied cells of the terrain.
+ * @param reachable Output bitboard of the occupied cells connected to the top row.
+ */
+void mark_reachable(const Occupancy& occupied, Occupancy& reachable);
+
+/**
+ * @brief Build the occupancy mask of a row of the terrain.
+ *
+ * @param terrain The terrain.
+ * @param row The row.
+ * @return RowBits The mask of the blocks with hit points left in the row.
+ */
+RowBits row_occupancy(const Terrain& terrain, int row);
+
+/**
+ * @brief Rebuild the occupancy bitboard from the terrain.
+ * @details Needed whenever g.terrain is assigned wholesale instead of through the terrain functions.
+ *
+ * @param g The game state.
+ */
+void rebuild_occupancy(GameState& g);
+
+/**
+ * @brief Rebuild the animating bitboard from the terrain.
+ * @details Needed whenever g.terrain is assigned wholesale instead of through the terrain functions.
+ * The dying bitboard can't be rebuilt, a dying block has no hit points left just like an empty cell.
+ *
+ * @param g The game state.
+ */
+void rebuild_block_sets(GameState& g);
+
+/**
+ * @brief Replace the terrain with a chunk, its blocks falling in from the top of the screen.
+ *
+ * @param g The game state.
+ * @param chunk The chunk, at most NUM_ROWS rows.
+ */
+void set_terrain(GameState& g, const Chunk& chunk);
+
+/**
+ * @brief Rebuild the exposed bitboard from the occupancy bitboard.
+ * @details Needed whenever rows of the occupancy change wholesale, deactivate_block() keeps it up to date otherwise.
+ * The top of the terrain sits against the wall, so row 0 only counts as exposed through its sides and the row below.
+ *
+ * @param g The game state.
+ */
+void rebuild_exposed(GameState& g);
+
+/**
+ * @brief Take a hit point off the block at a grid position, deactivating it when it has none left.
+ *
+ * @param g The game state.
+ * @param grid_pos The grid position of the block.
+ * @return true If the block broke.
+ */
+bool damage_block(GameState& g, ivec2 grid_pos);
+
+/**
+ * @brief Deactivate the block at a grid position, whatever its hit points, and clear it from the occupancy bitboard.
+ * @details The block itself is destroyed (and scored) by the next update_terrain().
+ * Its occupied neighbours are added to the exposed bitboard, and the block moves from the animating to the dying bitboard.
+ * An explosive block queues its explosion.
  *
  * @param g The game state.
- * @param row The row to start the search from.
- * @param col The column to start the search from.
- * @param visited The visited array.
+ * @param grid_pos The grid position of the block.
  */
-void dfs_mark_reachable(GameState& g, int row, int col, std::vector<std::vector<bool>>& visited);
+void deactivate_block(GameState& g, ivec2 grid_pos);
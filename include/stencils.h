@@ -0,0 +1,81 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief The largest stencil radius in the library, so a full stencil row (2 * radius + 1 cells) fits in a RowBits word.
+ *
+ */
+inline constexpr int MAX_STENCIL_RADIUS = 15;
+
+/**
+ * @brief A StencilShape is an enum of the shapes in the stencil library.
+ * @details SQUARE covers every cell within radius on both axes, CIRCLE every cell within a euclidean radius,
+ * DIAMOND every cell within a manhattan radius, and RING the one cell thick outline of the circle.
+ */
+enum StencilShape {
+    STENCIL_SQUARE,
+    STENCIL_CIRCLE,
+    STENCIL_DIAMOND,
+    STENCIL_RING,
+    NUM_STENCIL_SHAPES
+};
+
+/**
+ * @brief A Stencil is an area of terrain cells around a centre, stored as one row mask per row.
+ * @details Row dy + radius holds the cells at row offset dy, with bit dx + radius set for each cell at column offset dx.
+ * Placing the stencil is then one shift per row, which also clips it to the terrain.
+ */
+struct Stencil {
+    int radius;
+    RowBits rows[2 * MAX_STENCIL_RADIUS + 1];
+};
+
+/**
+ * @brief Build a stencil.
+ *
+ * @param shape The stencil shape.
+ * @param radius The stencil radius (clamped to [0, MAX_STENCIL_RADIUS]).
+ * @return Stencil The new stencil.
+ */
+Stencil new_stencil(StencilShape shape, int radius);
+
+/**
+ * @brief Get a stencil from the precomputed library (every shape at every radius, built once on first use).
+ *
+ * @param shape The stencil shape.
+ * @param radius The stencil radius (clamped to [0, MAX_STENCIL_RADIUS]).
+ * @return const Stencil& The stencil.
+ */
+const Stencil& get_stencil(StencilShape shape, int radius);
+
+/**
+ * @brief Get the terrain mask of one stencil row placed at a centre column, clipped to the terrain.
+ *
+ * @param s The stencil.
+ * @param dy The row offset from the centre, in [-radius, radius].
+ * @param center_x The centre column.
+ * @return RowBits The mask of the terrain cells covered in that row.
+ */
+RowBits stencil_row_mask(const Stencil& s, int dy, int center_x);
+
+/**
+ * @brief Deactivate every active block under a stencil.
+ *
+ * @param g The game state.
+ * @param s The stencil.
+ * @param center The grid position of the stencil centre.
+ * @return int The number of blocks deactivated.
+ */
+int apply_stencil(GameState& g, const Stencil& s, ivec2 center);
+
+/**
+ * @brief Queue every active block under a stencil for erosion (skipping blocks already queued).
+ * @details The blocks are eaten by update_erosion() over the following updates.
+ *
+ * @param g The game state.
+ * @param s The stencil.
+ * @param center The grid position of the stencil centre.
+ * @return int The number of blocks queued.
+ */
+int queue_erosion(GameState& g, const Stencil& s, ivec2 center);
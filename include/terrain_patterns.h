@@ -4,15 +4,55 @@
 
 /**
  * @brief Generate a grid pattern with the given number of rows and columns.
+ * @details The patterns also set the durability of their blocks (the hit points of the chunk's cells).
  *
  * @param rows The number of rows in the grid.
  * @param cols The number of columns in the grid.
- * @return Grid The generated grid.
+ * @param rng The random number generator the pattern parameters are rolled from.
+ * @return Chunk The generated chunk.
  */
-Grid grid_pattern(int rows, int cols);
-Grid sine_pattern(int rows, int cols);
-Grid circle_lattice_pattern(int rows, int cols);
-Grid sine_landscape(int rows, int cols);
+Chunk grid_pattern(int rows, int cols, XOR& rng);
+Chunk sine_pattern(int rows, int cols, XOR& rng);
+Chunk circle_lattice_pattern(int rows, int cols, XOR& rng);
+Chunk sine_landscape(int rows, int cols, XOR& rng);
+
+/**
+ * @brief Generate a noise pattern with the given number of rows and columns (noise.h).
+ * @details Caves are solid rock with holes in it, veins thin winding seams and strata bent layers.
+ *
+ * @param rows The number of rows in the grid.
+ * @param cols The number of columns in the grid.
+ * @param rng The random number generator the pattern parameters are rolled from.
+ * @return Chunk The generated chunk.
+ */
+Chunk cave_pattern(int rows, int cols, XOR& rng);
+Chunk vein_pattern(int rows, int cols, XOR& rng);
+Chunk strata_pattern(int rows, int cols, XOR& rng);
+
+/**
+ * @brief The patterns, indexed by PatternKind.
+ *
+ */
+inline constexpr PatternFunc PATTERNS[NUM_PATTERNS] = {
+    sine_landscape,
+    grid_pattern,
+    sine_pattern,
+    circle_lattice_pattern,
+    cave_pattern,
+    vein_pattern,
+    strata_pattern,
+};
+
+/**
+ * @brief Generate a chunk of a pattern.
+ *
+ * @param pattern The pattern.
+ * @param rows The number of rows in the chunk.
+ * @param cols The number of columns the pattern spans, centred in the chunk.
+ * @param rng The random number generator the pattern parameters are rolled from.
+ * @return Chunk The generated chunk.
+ */
+Chunk generate_chunk(PatternKind pattern, int rows, int cols, XOR& rng);
 
 /**
  * @brief Check if a position is on the edge of a rectangle.
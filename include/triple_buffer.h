@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free triple buffer handing the latest value from one writer thread to one reader thread.
+ * @details The writer fills back() and publish()es it, the reader calls acquire() and reads front().
+ * Neither side ever waits: a publish swaps the back slot with the shared middle slot, and an acquire swaps the
+ * front slot with the middle slot if something new was published since. Values the reader never got to are overwritten,
+ * it always sees the most recent one. The slots are reused, so values holding vectors stop allocating once warm.
+ * @tparam T The value type.
+ */
+template<typename T>
+struct TripleBuffer {
+    /**
+     * @brief Constructor, slot 0 starts as the reader's, slot 1 the writer's.
+     * @details The slots are value-initialized, so front() is a zeroed value until the first acquire().
+     */
+    TripleBuffer() : front_index(0), back_index(1), middle(2) {}
+
+    /**
+     * @brief The slot the writer fills. Only the writer thread may touch it.
+     */
+    inline T& back() { return slots[back_index]; }
+
+    /**
+     * @brief Hand the back slot to the reader and take the middle slot to write next.
+     * @details The new back slot holds an older value, the writer is expected to overwrite it.
+     */
+    inline void publish();
+
+    /**
+     * @brief Take the most recently published value, if there is a new one.
+     * @return true if front() changed.
+     */
+    inline bool acquire();
+
+    /**
+     * @brief The slot the reader reads. Only the reader thread may touch it.
+     */
+    inline const T& front() const { return slots[front_index]; }
+
+private:
+    static constexpr uint8_t FRESH = 4; ///< Set on the middle index when it holds a value the reader hasn't taken.
+
+    T slots[3]{};
+    uint8_t front_index; ///< Reader's slot.
+    uint8_t back_index; ///< Writer's slot.
+    std::atomic<uint8_t> middle; ///< The slot in between, plus the FRESH flag.
+};
+
+// Inline function definitions
+
+template<typename T>
+inline void TripleBuffer<T>::publish() {
+    // release so the reader sees the writes to the slot, acquire so the slot we get back is done being read
+    back_index = middle.exchange(back_index | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+template<typename T>
+inline bool TripleBuffer<T>::acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+        return false;
+    }
+    front_index = middle.exchange(front_index, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+}
@@ -1,47 +1,105 @@
 #pragma once
 
-#include <memory>
 #include <vector>
 #include "splashkit.h"
-#include <functional>
+#include "XOR.h"
+#include <deque>
+#include <utility>
+#include "occupancy.h"
+#include "pools.h"
 
 struct ivec2;
 struct GameState;
 struct Paddle;
 struct Ball;
-struct Block;
 struct Particle;
 
 
 /**
- * @brief A Row is a vector of unique pointers to blocks.
- * @details A Row is used to represent a row of blocks in the game.
+ * @brief A BallEffect is a function pointer that is used to represent the effect of a ball.
+ * @details A BallEffect takes a ball, grid position (of the block the ball collided with),
+ * and game state as arguments and returns a boolean.
+ * The boolean is used immediately after the effect function call in the ball_check_block_collision (ball_state.cpp) function to determine if the ball should
+ * change direction after colliding with a block (or not, like with acid).
+ * Balls don't hold the function pointer themselves, they hold a BallEffectId indexing the BALL_EFFECTS table (ball_effects.h).
  */
-using Row = std::vector<std::unique_ptr<Block>>;
+using BallEffect = bool (*)(Ball& ball, ivec2 grid_pos, GameState& game);
 
 /**
- * @brief A Grid is a vector of rows.
- * @details A Grid is used to represent the grid of blocks in the game.
+ * @brief A BallEffectId identifies the effect of a ball.
+ * @details The id indexes the BALL_EFFECTS table. Balls are kept grouped by id so each effect's update runs as its own loop
+ * with the effect call resolved at compile time. The id is plain data, so balls can be saved and handed between threads.
+ * Append only, the value is what gets saved in snapshots.
  */
-using Grid = std::vector<Row>;
+enum BallEffectId : uint8_t {
+    EFFECT_STANDARD,
+    EFFECT_EXPLOSION,
+    EFFECT_ACID,
+    NUM_BALL_EFFECTS
+};
 
 /**
- * @brief A BallEffect is a function pointer that is used to represent the effect of a ball.
- * @details A BallEffect takes a ball, grid position (of the block the ball collided with),
- * and game state as arguments and returns a boolean.
- * The boolean is used immediately after the effect function call in the ball_check_wall_collision (ball_state.cpp) function to determine if the ball should
- * change direction after colliding with a block (or not, like with acid).
- * We are using a raw pointer instead of std::function here as the global ball vector gets resized and we don't
- * want Ball to have to implement move and copy semantics.
+ * @brief A PowerUpKind identifies what a powerup does when the paddle catches it.
+ * @details The id indexes the POWERUP_EFFECTS table (powerup_effects.h). Append only, the value is what gets saved in snapshots.
  */
-using BallEffect = bool (*)(Ball& ball, ivec2 grid_pos, GameState& game);
+enum PowerUpKind : uint8_t {
+    POWERUP_WIDEN,
+    POWERUP_SHRINK,
+    POWERUP_MULTIBALL,
+    NUM_POWERUP_KINDS
+};
+
+/**
+ * @brief A Chunk is a block of terrain generated by a pattern, NUM_COLS wide, as one hit point byte per cell.
+ * @details The cells are stored row-major and a cell with 0 hit points is empty.
+ * The hit points are the block's durability, the number of ball hits it takes to break (at most MAX_BLOCK_HP).
+ */
+struct Chunk {
+    int rows;
+    std::vector<uint8_t> hp;
+};
+
+/**
+ * @brief A PatternKind identifies a terrain pattern.
+ * @details The id indexes the PATTERNS table (terrain_patterns.h).
+ */
+enum PatternKind : uint8_t {
+    PATTERN_SINE_LANDSCAPE,
+    PATTERN_GRID,
+    PATTERN_SINE,
+    PATTERN_CIRCLE_LATTICE,
+    PATTERN_CAVE,
+    PATTERN_VEIN,
+    PATTERN_STRATA,
+    NUM_PATTERNS
+};
 
 /**
- * @brief A PatternFunc is a function that is used to generate a pattern of blocks against a Grid.
- * @details A PatternFunc is a function that takes a width and height dimension as arguments and returns a grid.
- * The grid is used to represent the blocks in the game.
+ * @brief A PatternFunc is a function that is used to generate a pattern of blocks as a Chunk.
+ * @details A PatternFunc is a function that takes a width and height dimension and the random number generator
+ * to roll its parameters from as arguments and returns a chunk.
  */
-using PatternFunc = std::function<Grid(int, int)>;
+using PatternFunc = Chunk (*)(int rows, int cols, XOR& rng);
+
+/**
+ * @brief A ChunkCorpus is an open chunk corpus file, a set of chunks generated ahead of time (chunk_corpus.h).
+ * @details The data points at the file's bytes, memory-mapped read only where the platform can, otherwise read into the buffer.
+ * The size table is the first chunk and number of chunks of each size (indexed by rows - 1), and the index and chunk data
+ * point into the file.
+ * The hash identifies the file's contents (never 0 for an open corpus), snapshots record it since the terrain depends on the corpus.
+ */
+struct ChunkCorpus {
+    const uint8_t* data;
+    size_t size;
+    std::vector<uint8_t> buffer;
+    bool mapped;
+    uint32_t num_chunks;
+    uint32_t first[NUM_ROWS];
+    uint32_t count[NUM_ROWS];
+    const uint8_t* index;
+    const uint8_t* chunk_data;
+    uint64_t hash;
+};
 
 /**
  * @brief A point_2d is a small struct that is used to represent a point in 2D space.
@@ -53,31 +111,37 @@ struct ivec2 {
 
 /**
  * @brief A GameStatus is an enum that is used to represent the status of the game.
- * @details A GameStatus can be MENU, PLAYING, or GAME_OVER.
+ * @details A GameStatus can be MENU, PLAYING, or GAME_OVER. NUM_GAME_STATUSES counts them.
  */
 enum GameStatus {
     MENU,
     PLAYING,
-    GAME_OVER
+    GAME_OVER,
+    NUM_GAME_STATUSES
 };
 
 /**
  * @brief A paddle is a small struct that is used to represent the paddle in the game.
- * @details A paddle has a position, width, height, and color.
+ * @details A paddle has a position, width, height, color, steering target, and autopilot flag.
+ * The target x is where the player is steering the paddle (the mouse), set by the input loop before each update
+ * so the simulation never reads input itself.
+ * When autopilot is set the paddle tracks the balls itself instead of following the target (used for headless simulation).
  */
 struct Paddle {
     int x, y;
     int width;
     int height;
     color clr;
+    int target_x;
+    bool autopilot;
 };
 
 /**
  * @brief A particle is a small struct that is used to represent debris in the game.
- * @details A particle has a position, velocity, size, color, time to live, and original size.
- * The time to live is the number of updates the particle will be drawn for before being removed.
- * The original size is used to determine how the particle will shrink over time.
- * The maximum time to live is used to determine how much of the ttl has lapsed to inform other routines (alpha channel etc)
+ * @details A particle has a position, velocity, size, color, time to live, and birth tick.
+ * The time to live is the number of updates the particle lasts, it expires at tick birth + ttl (through GameState::particle_timers).
+ * Neither is counted down: the particle fades in and shrinks to half its size as it ages,
+ * worked out from its age when it is drawn, so the size and color are what it was spawned with.
  */
 struct Particle {
     point_2d pos;
@@ -85,61 +149,87 @@ struct Particle {
     int size;
     color clr;
     int ttl;
-    int max_ttl;
-    int original_size;
+    uint32_t birth;
 };
 
 /**
  * @brief A ball is a small struct that is used to represent the ball in the game.
- * @details A ball has a position, velocity, size, color, effect, time to live type, time to live, and maximum time to live.
+ * @details A ball has a position, velocity, size, color, effect, time to live type, time to live, and birth tick.
  * The time to live type is used to determine how the ball will be removed from the game.
  * The time to live type can be 0, 1, or 2. 0 means the ball will not be removed, 1 means the ball will be removed after a certain number of hits, and 2 means the ball will be removed after a certain number of updates.
- * The maximum time to live is used to determine how much of the ttl has lapsed to inform other routines (alpha channel etc)
+ * Hits count the ttl down, updates aren't counted: the ball expires at tick birth + ttl (through GameState::ball_timers).
+ * The trail is the ball's last BALL_TRAIL_LENGTH positions, BALL_TRAIL_SPACING apart, drawn as one tapered ribbon.
  */
 struct Ball {
     point_2d pos;
     vector_2d vel;
     int size;
     color clr;
-    BallEffect effect;
+    BallEffectId effect;
     bool active;
-    std::vector<Particle> trail;
+    Ring<point_2d, BALL_TRAIL_LENGTH> trail;
     int ttl_type; // 0 = none, 1 = # hits, 2 = # updates
     int ttl;
-    int max_ttl;
+    uint32_t birth;
 };
 
 /**
- * @brief A block is a small struct that is used to represent the blocks in the game.
- * @details A block has a position, target position, grid position, width, height, color, activity status, and vertical velocity.
- * The target position is used to determine where the block should move to.
- * The target position is just used when the block is due to fall to a new grid position instead of updating instantly.
- * The grid position is used to determine where the block is in the grid (mappable to target pos).
- * The vertical velocity is used to determine how fast the block should move (set to 0 when pos == target_pos).
+ * @brief A BallGrid is a uniform spatial hash of the balls over the game area, rebuilt every update to find touching balls.
+ * @details The balls are counting sorted by cell: the balls in cell c are items[cell_start[c], cell_start[c + 1]),
+ * as indices into GameState::balls, and ball_cell is each ball's cell. Each item's position and size are copied alongside it,
+ * so testing the balls of neighbouring cells reads contiguous memory instead of whole balls. The pairs are the touching balls found in the grid,
+ * lower index first, in ascending order.
+ * All of it is scratch space kept between updates, so rebuilding the grid doesn't allocate once it has grown.
  */
-struct Block {
-    point_2d pos;
-    point_2d target_pos;
-    ivec2 grid_pos;
-    int width;
-    int height;
-    color clr;
-    bool active;
-    float y_vel;
+struct BallGrid {
+    std::vector<uint32_t> cell_start;
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> ball_cell;
+    std::vector<point_2d> item_pos;
+    std::vector<int> item_size;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+};
+
+/**
+ * @brief A Terrain is the blocks of the game, stored as one entry per cell in each array (indexed by cell_index()).
+ * @details The hit points are how many more ball hits the block takes to break, 0 for an empty cell.
+ * The y position is the screen y of the block's top edge. A block falls until it reaches the top of its row,
+ * and the y velocity is how fast it is falling (0 once settled).
+ * A block's x position, size and colour are not stored: the first two follow from its cell and the colour is picked
+ * from its hit points when it is drawn, so a block costs 9 bytes.
+ */
+struct Terrain {
+    std::array<uint8_t, NUM_CELLS> hp;
+    std::array<float, NUM_CELLS> y;
+    std::array<float, NUM_CELLS> y_vel;
 };
 
 /**
  * @brief A powerup is a small struct that is used to represent the powerups in the game.
- * @details A powerup has a position, velocity, size, color, activity status, and trail.
- * The trail is a vector of particles that is used to represent the trail of the powerup.
+ * @details A powerup has a position, velocity, size, color and kind.
+ * Powerups drop from broken blocks and fall until the paddle catches them (applying the kind's effect) or they leave the game area.
+ * They live in the game state's powerup slot map, so there is no activity flag: a powerup is removed from the map instead.
+ * Their trails share one particle ring in the game state rather than each owning a vector.
  */
 struct PowerUp {
     point_2d pos;
     vector_2d vel;
     int size;
     color clr;
-    bool active;
-    std::vector<Particle> trail;
+    PowerUpKind kind;
+};
+
+/**
+ * @brief A RngStreams is the set of random number generators owned by a game state, one per subsystem.
+ * @details The streams are split from a single seed so a game is reproducible, but draw independently:
+ * the terrain stream rolls chunk patterns and parameters, the gameplay stream rolls anything that affects play
+ * (ball types, powerup drops, spawn positions), and the cosmetic stream rolls particles and trails.
+ * Adding or removing a visual effect only shifts the cosmetic stream, so gameplay stays deterministic.
+ */
+struct RngStreams {
+    XOR terrain;
+    XOR gameplay;
+    XOR cosmetic;
 };
 
 /**
@@ -147,16 +237,66 @@ struct PowerUp {
  * @details A game state has a game status, score, terrain, balls, particles, and paddle.
  * The game status is used to determine what state the game is in.
  * The score is used to determine the player's score.
- * The terrain is a grid of blocks that is used to represent the blocks in the game.
- * The balls is a vector of balls that is used to represent the balls in the game.
- * The particles is a vector of particles that is used to represent the particles in the game.
+ * The tick is the number of updates run, what particles and balls are timed by.
+ * The terrain holds the blocks of the game.
+ * The occupancy is a bitboard of the blocks with hit points left, kept in sync with the terrain by the terrain functions
+ * (terrain_state.cpp) so row queries don't have to walk the cells.
+ * The exposed bitboard is the subset of the occupancy with an empty neighbour (diagonals included), the only blocks a ball can reach,
+ * so collision checks skip the interior of the terrain.
+ * The animating bitboard marks the blocks still falling to their target position and the dying bitboard the deactivated blocks
+ * waiting to be destroyed, so update_terrain() only visits blocks with something to do and settled terrain costs nothing.
+ * The connectivity dirty bitboard marks cells removed since the last disconnected-cluster pass, so the pass only rechecks
+ * the terrain around them.
+ * The erosion queue holds cells waiting to be eaten by acid, worked through a few cells per update, and the erosion pending
+ * bitboard marks the queued cells so each is queued once. The eroded bitboard marks the dying blocks acid ate, whose debris
+ * comes off acid coloured.
+ * The explosive bitboard marks the blocks that explode when destroyed (kept until the dying block is gone, for its debris). Their explosions wait in the explosion queue and go off
+ * a few per update, breadth first, so a chain reaction spreads over several updates; the explosion pending bitboard marks
+ * the queued cells so each explodes once.
+ * The balls, particles and powerups are held in slot maps, so other state can refer to one by Handle and safely find out
+ * when it is gone. The particle and ball timers hold the handles of the particles and balls with a lifetime, by the tick they expire,
+ * so expiring them only touches the ones due. They are derived from the particles and balls, snapshots don't keep them.
+ * The expired particles are scratch space for the indices of the particles expiring in an update.
+ * The balls is a slot map of balls that is used to represent the balls in the game.
+ * The ball grid is the spatial hash ball-ball collisions are found with, and ball collisions toggles them.
+ * The toggle changes how the balls move, so unlike the quality it is part of the game and saved in snapshots.
+ * The particles is a slot map of particles that is used to represent the particles in the game.
+ * The powerups are the falling powerups (at most MAX_POWERUPS, reserved up front), and the powerup trail is the particle ring
+ * all of their trails are drawn from, so dropping powerups never allocates.
  * The paddle is used to represent the paddle in the game.
+ * The rng is the game's own set of random number streams, so independent game states can run side by side (on separate threads).
+ * The corpus is the chunk corpus new chunks are drawn from instead of generated, or null to generate every chunk.
+ * It isn't owned by the game state and has to stay open while the game runs.
+ * The quality is the cosmetic detail level in [MIN_QUALITY, 1], set by the quality governor (quality.h) when frames run long.
+ * It scales particle emission and lifetime only, never anything gameplay reads.
  */
 struct GameState {
     GameStatus status;
     int score;
-    Grid terrain;
-    std::vector<Ball> balls;
-    std::vector<Particle> particles;
+    uint32_t tick;
+    Terrain terrain;
+    Occupancy occupancy;
+    Occupancy exposed;
+    Occupancy animating;
+    Occupancy dying;
+    Occupancy connectivity_dirty;
+    std::deque<ivec2> erosion_queue;
+    Occupancy erosion_pending;
+    Occupancy eroded;
+    Occupancy explosive;
+    std::deque<ivec2> explosion_queue;
+    Occupancy explosion_pending;
+    SlotMap<Ball> balls;
+    BallGrid ball_grid;
+    bool ball_collisions;
+    TimerWheel<BALL_TIMER_SLOTS> ball_timers;
+    SlotMap<Particle> particles;
+    TimerWheel<PARTICLE_TIMER_SLOTS> particle_timers;
+    std::vector<uint32_t> expired_particles;
+    SlotMap<PowerUp> powerups;
+    Ring<Particle, POWERUP_TRAIL_CAPACITY> powerup_trail;
     Paddle paddle;
+    RngStreams rng;
+    const ChunkCorpus* corpus;
+    float quality;
 };
@@ -0,0 +1,194 @@
+#include "include/noise.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(NOISE_NO_SIMD)
+#include <emmintrin.h>
+#define NOISE_SSE2 1
+#endif
+
+// LATTICE
+// The value at lattice point (ix, iy) of an octave hashes ix * HASH_X ^ iy * HASH_Y ^ seed. A row of cells only ever
+// falls between two lattice rows, so each octave first blends those two rows into one value per lattice column,
+// hashing every lattice point the row touches once, and the cells then only interpolate between their two columns.
+// Features span several cells, so there are far fewer lattice columns than cells to hash.
+// The blended columns are kept in a buffer on the stack, so a row too long for it (or an octave fine enough) is
+// worked through in segments of cells whose columns fit.
+
+static constexpr uint32_t HASH_X = 0x8DA6B343u;
+static constexpr uint32_t HASH_Y = 0xD8163841u;
+static constexpr uint32_t OCTAVE_SEED_STEP = 0x9E3779B9u;
+static constexpr int MAX_NOISE_OCTAVES = 8;
+static constexpr int NOISE_LATTICE_COLUMNS = 64;
+
+/**
+ * @brief Finish a lattice hash into a value in [0, 1).
+ */
+static inline float lattice_value(uint32_t h) {
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief Ease an interpolation weight so the field is smooth across lattice points.
+ */
+static inline float smooth(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+#ifdef NOISE_SSE2
+/**
+ * @brief Multiply 32-bit lanes keeping the low halves (SSE2 has no 32-bit mullo).
+ */
+static inline __m128i mullo_epi32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128 lattice_value4(__m128i h) {
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = mullo_epi32(h, _mm_set1_epi32(0x2C1B3C6D));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+    h = mullo_epi32(h, _mm_set1_epi32(0x297A2D39));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+}
+#endif
+
+/**
+ * @brief Blend the two lattice rows around a row of cells into one value per lattice column.
+ *
+ * @param out Output value of each lattice column.
+ * @param first The first lattice column.
+ * @param count The number of lattice columns.
+ * @param hash_top The row half of the hash of the lattice row above.
+ * @param hash_bottom The row half of the hash of the lattice row below.
+ * @param sy The eased weight of the row below.
+ */
+static void blend_lattice_rows(float* out, int first, int count, uint32_t hash_top, uint32_t hash_bottom, float sy) {
+    int k = 0;
+#ifdef NOISE_SSE2
+    __m128i top_hash = _mm_set1_epi32(static_cast<int>(hash_top));
+    __m128i bottom_hash = _mm_set1_epi32(static_cast<int>(hash_bottom));
+    __m128i step = _mm_set1_epi32(static_cast<int>(4 * HASH_X));
+    __m128i hx = mullo_epi32(_mm_add_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3)), _mm_set1_epi32(static_cast<int>(HASH_X)));
+    __m128 weight = _mm_set1_ps(sy);
+    for (; k + 4 <= count; k += 4, hx = _mm_add_epi32(hx, step)) {
+        __m128 top = lattice_value4(_mm_xor_si128(hx, top_hash));
+        __m128 bottom = lattice_value4(_mm_xor_si128(hx, bottom_hash));
+        _mm_storeu_ps(out + k, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), weight)));
+    }
+#endif
+    for (; k < count; ++k) {
+        uint32_t hx = static_cast<uint32_t>(first + k) * HASH_X;
+        float top = lattice_value(hx ^ hash_top);
+        float bottom = lattice_value(hx ^ hash_bottom);
+        out[k] = top + (bottom - top) * sy;
+    }
+}
+
+/**
+ * @brief Add one octave to a row of cells, interpolating between the lattice columns.
+ *
+ * @param out The row of cells to add to.
+ * @param begin The first cell.
+ * @param end One past the last cell.
+ * @param lattice The blended lattice columns.
+ * @param first The lattice column lattice[0] holds.
+ * @param frequency The lattice columns per cell.
+ * @param weight The weight of the octave.
+ * @param ridged Whether to fold the octave.
+ */
+static void add_octave(float* out, int begin, int end, const float* lattice, int first, float frequency, float weight, bool ridged) {
+    int x = begin;
+#ifdef NOISE_SSE2
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128i first_column = _mm_set1_epi32(first);
+    for (; x + 4 <= end; x += 4) {
+        __m128 fx = _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)), _mm_set1_ps(frequency));
+        __m128i ix = _mm_cvttps_epi32(fx);
+        __m128 tx = _mm_sub_ps(fx, _mm_cvtepi32_ps(ix));
+        __m128 sx = _mm_mul_ps(_mm_mul_ps(tx, tx), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), tx)));
+        alignas(16) int columns[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(columns), _mm_sub_epi32(ix, first_column));
+        __m128 left = _mm_setr_ps(lattice[columns[0]], lattice[columns[1]], lattice[columns[2]], lattice[columns[3]]);
+        __m128 right = _mm_setr_ps(lattice[columns[0] + 1], lattice[columns[1] + 1], lattice[columns[2] + 1], lattice[columns[3] + 1]);
+        __m128 n = _mm_add_ps(left, _mm_mul_ps(_mm_sub_ps(right, left), sx));
+        if (ridged) {
+            __m128 folded = _mm_sub_ps(_mm_add_ps(n, n), one);
+            n = _mm_sub_ps(one, _mm_andnot_ps(_mm_set1_ps(-0.0f), folded)); // clearing the sign bit is fabs
+        }
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(out + x), _mm_mul_ps(n, _mm_set1_ps(weight)));
+        _mm_storeu_ps(out + x, sum);
+    }
+#endif
+    for (; x < end; ++x) {
+        float fx = static_cast<float>(x) * frequency;
+        int ix = static_cast<int>(fx); // coordinates are never negative, so truncating is flooring
+        float sx = smooth(fx - static_cast<float>(ix));
+        const float* column = lattice + (ix - first);
+        float n = column[0] + (column[1] - column[0]) * sx;
+        if (ridged) {
+            n = 1.0f - std::fabs(n + n - 1.0f);
+        }
+        out[x] += n * weight;
+    }
+}
+
+void noise_row(const NoiseParams& p, int row, float* out, int count) {
+    if (count <= 0) return;
+    int num_octaves = std::clamp(p.octaves, 1, MAX_NOISE_OCTAVES);
+    std::fill(out, out + count, 0.0f);
+    float lattice[NOISE_LATTICE_COLUMNS];
+
+    float frequency_x = p.frequency_x;
+    float frequency_y = p.frequency_y;
+    float weight = 1.0f;
+    float total_weight = 0.0f;
+    for (int i = 0; i < num_octaves; ++i) {
+        uint32_t seed = p.seed + static_cast<uint32_t>(i) * OCTAVE_SEED_STEP;
+        float fy = static_cast<float>(row) * frequency_y;
+        int iy = static_cast<int>(fy);
+        // cell x falls between lattice columns x * frequency and the one after, so n cells span (n - 1) * frequency
+        // columns, up to two more at the ends and one more for the products rounding up across a column
+        float cells = static_cast<float>(NOISE_LATTICE_COLUMNS - 4) / frequency_x;
+        int segment = cells >= static_cast<float>(count) ? count : std::max(1, static_cast<int>(cells));
+        for (int begin = 0; begin < count; begin += segment) {
+            int end = std::min(begin + segment, count);
+            int first = static_cast<int>(static_cast<float>(begin) * frequency_x);
+            int columns = static_cast<int>(static_cast<float>(end - 1) * frequency_x) - first + 2;
+            blend_lattice_rows(lattice, first, columns, static_cast<uint32_t>(iy) * HASH_Y ^ seed,
+                               static_cast<uint32_t>(iy + 1) * HASH_Y ^ seed, smooth(fy - static_cast<float>(iy)));
+            add_octave(out, begin, end, lattice, first, frequency_x, weight, p.ridged);
+        }
+        total_weight += weight;
+        frequency_x *= 2.0f;
+        frequency_y *= 2.0f;
+        weight *= p.persistence;
+    }
+
+    float scale = 1.0f / total_weight;
+    for (int x = 0; x < count; ++x) {
+        out[x] *= scale;
+    }
+}
+
+RowBits threshold_mask(const float* values, int count, float threshold) {
+    RowBits bits = 0;
+    int x = 0;
+#ifdef NOISE_SSE2
+    __m128 t = _mm_set1_ps(threshold);
+    for (; x + 4 <= count; x += 4) {
+        bits |= static_cast<RowBits>(_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(values + x), t))) << x;
+    }
+#endif
+    for (; x < count; ++x) {
+        bits |= static_cast<RowBits>(values[x] > threshold) << x;
+    }
+    return bits;
+}
@@ -5,5 +5,28 @@
 #include "include/draw.h"
 
 void paddle_update(GameState& g) {
-    g.paddle.x = clamp((int) mouse_x(), GAME_AREA_START, GAME_AREA_END - g.paddle.width);
+    int target_x = g.paddle.autopilot ? paddle_autopilot_target(g) : g.paddle.target_x;
+    g.paddle.x = clamp(target_x, GAME_AREA_START, GAME_AREA_END - g.paddle.width);
+}
+
+int paddle_autopilot_target(const GameState& g) {
+    // track the lowest falling ball
+    const Ball* target = nullptr;
+    for (const auto& b : g.balls) {
+        if (b.active && b.vel.y > 0 && (!target || b.pos.y > target->pos.y)) {
+            target = &b;
+        }
+    }
+    if (!target) {
+        return g.paddle.x;
+    }
+    // meet the ball off-centre so it leaves at an angle instead of bouncing straight up and down
+    int offset = target->vel.x >= 0 ? -g.paddle.width / 4 : g.paddle.width / 4;
+    return static_cast<int>(target->pos.x) - g.paddle.width / 2 + offset;
+}
+
+void paddle_resize(Paddle& p, int width) {
+    width = clamp(width, MIN_PADDLE_WIDTH, MAX_PADDLE_WIDTH);
+    p.x -= (width - p.width) / 2;
+    p.width = width;
 }
@@ -1,26 +1,91 @@
 #include "include/state_management.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+Handle spawn_particle(GameState& g, Particle p) {
+    p.birth = g.tick;
+    Handle h = g.particles.insert(p);
+    g.particle_timers.schedule(h, p.birth + p.ttl, g.tick);
+    return h;
+}
 
 void particle_update(Particle& p) {
     p.vel.y += 0.1;
     p.pos.x += p.vel.x;
     p.pos.y += p.vel.y;
-    p.ttl--;
+}
 
-    // Increase opacity based on the remaining ttl
-    float alpha = 1.0f - (static_cast<float>(p.ttl) / static_cast<float>(p.max_ttl));
-    p.clr.a = static_cast<uint8_t>(alpha * 255);
-    // Decrease size based on the remaining ttl
-    p.size = static_cast<int>(p.original_size * (1.0f - (alpha/2.0f)));
+float particle_lapsed(const Particle& p, uint32_t now) {
+    // the fraction of the ttl lapsed
+    return 1.0f - (static_cast<float>(p.ttl - static_cast<int>(now - p.birth)) / static_cast<float>(p.ttl));
+}
+
+void particle_collide_terrain(Particle& p, point_2d old_pos, const Occupancy& solid) {
+    if (cell_at(solid, old_pos.x, old_pos.y)) return;
+    bool hit_y = cell_at(solid, old_pos.x, p.pos.y);
+    bool hit_x = cell_at(solid, p.pos.x, old_pos.y);
+    if (hit_y || !hit_x) {
+        p.pos.y = old_pos.y;
+        p.vel.y *= -PARTICLE_RESTITUTION;
+        p.vel.x *= PARTICLE_FRICTION;
+        if (std::abs(p.vel.y) < PARTICLE_SETTLE_SPEED) p.vel.y = 0;
+    }
+    if (hit_x || !hit_y) {
+        p.pos.x = old_pos.x;
+        p.vel.x *= -PARTICLE_RESTITUTION;
+    }
 }
 
 void update_particles(GameState& g) {
-    for (auto& p : g.particles) {
-        particle_update(p);
+    // Remove the particles expiring this tick, the rest are never looked at for it.
+    // They go from the highest index down, so each hole is filled by a particle that stays and the order the particles
+    // end up in only depends on which expired, not on the order the wheel fired them in (a load doesn't keep that)
+    g.expired_particles.clear();
+    g.particle_timers.expire(g.tick, [&](Handle h) {
+        if (const Particle* p = g.particles.get(h)) {
+            g.expired_particles.push_back(static_cast<uint32_t>(p - g.particles.begin()));
+        }
+    });
+    std::sort(g.expired_particles.begin(), g.expired_particles.end(), std::greater<uint32_t>());
+    for (uint32_t i : g.expired_particles) {
+        g.particles.remove_at(i);
     }
 
-    // Remove dead particles
-    g.particles.erase(std::remove_if(g.particles.begin(), g.particles.end(),
-                                     [](const Particle& p) { return p.ttl <= 0; }),
-                      g.particles.end());
+    Occupancy solid;
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        solid[y] = g.occupancy[y] & ~g.animating[y];
+    }
+    // in batches: move every particle and collect the ones landing in solid cells without branching,
+    // then resolve just those (settled particles hit every tick, mixed in with free ones, so a branch would mispredict)
+    constexpr uint32_t BATCH = 256;
+    point_2d old_pos[BATCH];
+    uint32_t hits[BATCH];
+    for (uint32_t start = 0; start < g.particles.size(); start += BATCH) {
+        uint32_t end = std::min(start + BATCH, g.particles.size());
+        uint32_t num_hits = 0;
+        for (uint32_t i = start; i < end; ++i) {
+            Particle& p = g.particles[i];
+            old_pos[i - start] = p.pos;
+            particle_update(p);
+            hits[num_hits] = i;
+            num_hits += cell_at(solid, p.pos.x, p.pos.y);
+        }
+        for (uint32_t h = 0; h < num_hits; ++h) {
+            particle_collide_terrain(g.particles[hits[h]], old_pos[hits[h] - start], solid);
+        }
+    }
+}
+
+
+int particle_budget(GameState& g, int count) {
+    if (g.quality >= 1.0f) return count;
+    float scaled = count * g.quality;
+    int n = static_cast<int>(scaled);
+    if (g.rng.cosmetic.chance(scaled - n)) ++n;
+    return n;
 }
 
+int particle_ttl(const GameState& g, int ttl) {
+    return std::max(1, static_cast<int>(ttl * (0.5f + 0.5f * g.quality)));
+}
@@ -0,0 +1,29 @@
+#include "include/globals.h"
+#include "include/powerup_effects.h"
+#include "include/ball_effects.h"
+#include "include/state_init.h"
+#include "include/state_management.h"
+
+
+void powerup_widen(GameState& game) {
+    paddle_resize(game.paddle, static_cast<int>(game.paddle.width * PADDLE_WIDEN_FACTOR));
+}
+
+void powerup_shrink(GameState& game) {
+    paddle_resize(game.paddle, static_cast<int>(game.paddle.width * PADDLE_SHRINK_FACTOR));
+}
+
+void powerup_multiball(GameState& game) {
+    // launch a few rolled balls off the paddle, the balls aren't being iterated here so they can go straight in
+    for (int i = 0; i < 3; ++i) {
+        Ball b = roll_ball(game.rng.gameplay);
+        b.pos = {static_cast<double>(game.paddle.x + game.paddle.width / 2), static_cast<double>(game.paddle.y - 10)};
+        spawn_ball(game, b);
+    }
+}
+
+PowerUp roll_powerup(XOR& rng) {
+    PowerUpKind kind = static_cast<PowerUpKind>(rng.randomInt(0, NUM_POWERUP_KINDS - 1));
+    const color colors[NUM_POWERUP_KINDS] = {clr_powerup_widen, clr_powerup_shrink, clr_powerup_multiball};
+    return new_powerup({50, 50}, {0, 0}, POWERUP_SIZE, colors[kind], kind);
+}
@@ -0,0 +1,60 @@
+#include "include/globals.h"
+#include "include/state_management.h"
+#include "include/state_init.h"
+#include "include/powerup_effects.h"
+#include <algorithm>
+
+Handle spawn_powerup(GameState& g, const PowerUp& p) {
+    if (g.powerups.size() >= MAX_POWERUPS) {
+        return NULL_HANDLE;
+    }
+    return g.powerups.insert(p);
+}
+
+void powerup_update(PowerUp& p, GameState& g) {
+    p.vel.y = std::min(p.vel.y + POWERUP_GRAVITY, static_cast<double>(POWERUP_MAX_FALL_SPEED));
+    p.pos.x += p.vel.x;
+    p.pos.y += p.vel.y;
+    // trail particles keep their full ttl, the ring relies on them all lasting the same time
+    if (g.rng.cosmetic.chance(0.5f * g.quality)) {
+        float vel[2];
+        g.rng.cosmetic.fillFloats(vel, 2, -0.5f, 0.5f);
+        Particle trail = new_particle(p.pos, {vel[0], vel[1] - p.vel.y}, p.clr, 2, 20);
+        trail.birth = g.tick;
+        g.powerup_trail.push(trail);
+    }
+}
+
+bool powerup_check_paddle_collision(const PowerUp& p, const Paddle& paddle) {
+    return p.pos.x + p.size > paddle.x && p.pos.x - p.size < paddle.x + paddle.width &&
+           p.pos.y + p.size > paddle.y && p.pos.y - p.size < paddle.y + paddle.height;
+}
+
+void update_powerups(GameState& g) {
+    // every trail particle has the same ttl, so the oldest are always the first to die
+    while (!g.powerup_trail.empty() && g.tick - g.powerup_trail[0].birth >= static_cast<uint32_t>(g.powerup_trail[0].ttl)) {
+        g.powerup_trail.pop_oldest();
+    }
+    for (uint32_t i = 0; i < g.powerup_trail.size(); ++i) {
+        particle_update(g.powerup_trail[i]);
+    }
+
+    // walk backwards, removing an item moves the (already updated) last item into its place
+    for (uint32_t i = g.powerups.size(); i-- > 0;) {
+        PowerUp& p = g.powerups[i];
+        powerup_update(p, g);
+        if (powerup_check_paddle_collision(p, g.paddle)) {
+            float vel[20 * 2];
+            int n = particle_budget(g, 20);
+            int ttl = particle_ttl(g, 40);
+            g.rng.cosmetic.fillFloats(vel, n * 2, -2.0f, 2.0f);
+            for (int j = 0; j < n; ++j) {
+                spawn_particle(g, new_particle(p.pos, {vel[j * 2], vel[j * 2 + 1] - 2}, p.clr, 2, ttl));
+            }
+            POWERUP_EFFECTS[p.kind](g);
+            g.powerups.remove_at(i);
+        } else if (p.pos.y - p.size > GAME_AREA_HEIGHT) {
+            g.powerups.remove_at(i);
+        }
+    }
+}
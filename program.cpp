@@ -6,31 +6,259 @@
 #include "include/terrain_patterns.h"
 #include "include/ball_effects.h"
 #include "include/draw.h"
+#include "include/snapshot.h"
+#include "include/chunk_corpus.h"
+#include "include/renderer.h"
+#include "include/triple_buffer.h"
+#include "include/quality.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
+/**
+ * @brief The simulation rate, in updates per second.
+ *
+ */
+constexpr int SIM_TICKS_PER_SECOND = 60;
 
-int main()
+/**
+ * @brief The frame time the quality governor keeps the slower of the simulation and drawing under, in microseconds
+ * (three quarters of a 60 fps frame, leaving room for presenting).
+ *
+ */
+constexpr double FRAME_BUDGET_US = 1000000.0 / 60 * 0.75;
+
+/**
+ * @brief The number of presented frames each latency report (F3) covers.
+ *
+ */
+constexpr int LATENCY_REPORT_FRAMES = 120;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief An InputAction is a one-shot input for the simulation, as a bit in SimInput::actions.
+ *
+ */
+enum InputAction : uint32_t {
+    ACTION_SPAWN_STANDARD = 1 << 0,
+    ACTION_SPAWN_ACID = 1 << 1,
+    ACTION_SAVE = 1 << 2,
+    ACTION_LOAD = 1 << 3,
+    ACTION_TOGGLE_BALL_COLLISIONS = 1 << 4
+};
+
+/**
+ * @brief A SimInput is the input gathered by the main thread (which owns the window) for the simulation thread.
+ * @details Actions are OR'd in until the simulation takes them, so a click landing between two updates isn't lost.
+ * The mouse position and rewind key are just the latest state, the mouse time is when the position was sampled.
+ * The draw time is how long the main thread last took to draw a frame, fed back to the quality governor.
+ */
+struct SimInput {
+    std::atomic<int> mouse_x;
+    std::atomic<Clock::rep> mouse_time;
+    std::atomic<uint32_t> actions;
+    std::atomic<bool> rewind;
+    std::atomic<bool> quit;
+    std::atomic<float> draw_us;
+};
+
+/**
+ * @brief A SimFrame is a frame published by the simulation, with what the main thread needs to late-latch the paddle.
+ * @details When latch_paddle is set the paddle follows the mouse, so the main thread redraws the paddle pass at the
+ * mouse position sampled just before presenting instead of where the simulation saw it.
+ * The input time is when the mouse position the simulation used was sampled.
+ */
+struct SimFrame {
+    RenderFrame render;
+    bool latch_paddle;
+    Clock::rep input_time;
+};
+
+/**
+ * @brief Run the simulation at SIM_TICKS_PER_SECOND until told to quit, publishing a recorded frame after every update.
+ * @details Runs on its own thread and owns the game state, the main thread only ever sees the published frames.
+ *
+ * @param game The game state.
+ * @param input The input from the main thread.
+ * @param frames The triple buffer the frames are published through.
+ */
+static void simulate(GameState& game, SimInput& input, TripleBuffer<SimFrame>& frames) {
+    SnapshotRing rewind = new_snapshot_ring(300);
+    Renderer recorder = new_recording_renderer();
+    QualityGovernor governor = new_quality_governor(FRAME_BUDGET_US);
+    const auto tick = std::chrono::microseconds(1000000 / SIM_TICKS_PER_SECOND);
+    auto next_tick = std::chrono::steady_clock::now();
+    while (!input.quit) {
+        if (game.status == PLAYING) {
+            auto start = Clock::now();
+            uint32_t actions = input.actions.exchange(0);
+            // DEBUG
+            if (actions & ACTION_SPAWN_STANDARD) {
+                spawn_ball(game, new_ball({static_cast<double>(game.rng.gameplay.randomInt(GAME_AREA_START, GAME_AREA_END)), static_cast<double>(GAME_AREA_HEIGHT-100)}, {3, -3}, 3, clr_ball_standard, EFFECT_STANDARD, 0, 1));
+            }
+            if (actions & ACTION_SPAWN_ACID) {
+                spawn_ball(game, new_ball({static_cast<double>(game.rng.gameplay.randomInt(GAME_AREA_START, GAME_AREA_END)), static_cast<double>(GAME_AREA_HEIGHT-100)}, {3, -3}, 3, clr_ball_acid, EFFECT_ACID, 2, 700));
+            }
+            if (actions & ACTION_SAVE) {
+                save_snapshot_file(game, "scenario.brkn");
+            } else if (actions & ACTION_LOAD) {
+                load_snapshot_file(game, "scenario.brkn");
+            }
+            if (actions & ACTION_TOGGLE_BALL_COLLISIONS) {
+                game.ball_collisions = !game.ball_collisions;
+            }
+            // END DEBUG
+
+            // hold R to rewind
+            bool rewinding = input.rewind;
+            Clock::rep input_time = input.mouse_time;
+            if (rewinding) {
+                snapshot_ring_rewind(rewind, game);
+            } else {
+                game.paddle.target_x = input.mouse_x;
+                update_global_state(game);
+                snapshot_ring_push(rewind, game);
+            }
+            SimFrame& frame = frames.back();
+            begin_recording(recorder, frame.render);
+            draw_global_state(game, recorder);
+            frame.latch_paddle = !rewinding && !game.paddle.autopilot;
+            frame.input_time = input_time;
+            frames.publish();
+
+            // the stages overlap, so the slower one sets the frame rate
+            double sim_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            game.quality = update_quality_governor(governor, std::max<double>(sim_us, input.draw_us));
+        }
+
+        // fixed rate, but don't try to catch up after a stall
+        next_tick += tick;
+        auto now = Clock::now();
+        if (next_tick < now - tick) {
+            next_tick = now;
+        }
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+/**
+ * @brief Gather the window's input for the simulation.
+ *
+ * @param input The input to fill.
+ */
+static void read_input(SimInput& input) {
+    process_events();
+    uint32_t actions = 0;
+    if (mouse_clicked(MOUSE_X1_BUTTON)) actions |= ACTION_SPAWN_STANDARD;
+    if (mouse_clicked(MOUSE_X2_BUTTON)) actions |= ACTION_SPAWN_ACID;
+    if (key_typed(F5_KEY)) actions |= ACTION_SAVE;
+    if (key_typed(F9_KEY)) actions |= ACTION_LOAD;
+    if (key_typed(F6_KEY)) actions |= ACTION_TOGGLE_BALL_COLLISIONS;
+    input.actions |= actions;
+    input.mouse_x = static_cast<int>(mouse_x());
+    input.mouse_time = Clock::now().time_since_epoch().count();
+    input.rewind = key_down(R_KEY);
+}
+
+/**
+ * @brief Draw a published frame, redrawing the paddle at the latest mouse position if it follows the mouse.
+ * @details Everything before the paddle pass is drawn first, then input is read, so the mouse is sampled as late as
+ * possible: after the expensive part of the frame and just before presenting. The simulation also collides against
+ * this sample on its next update.
+ *
+ * @param frame The frame.
+ * @param input The input to fill.
+ * @param late_latch Whether to redraw the paddle at the latest mouse position.
+ * @param r The renderer.
+ * @return Clock::rep When the paddle position on screen was sampled.
+ */
+static Clock::rep draw_frame(const SimFrame& frame, SimInput& input, bool late_latch, Renderer& r) {
+    const RenderFrame& f = frame.render;
+    uint32_t paddle_begin = f.pass_begin[PASS_PADDLE];
+    uint32_t paddle_end = f.pass_end[PASS_PADDLE];
+    replay_commands(f, 0, paddle_begin, r);
+    read_input(input);
+
+    double dx = 0;
+    Clock::rep sampled = frame.input_time;
+    // the paddle is found by its mark rather than where it sits in the paddle pass (frames not yet published have no commands)
+    if (late_latch && frame.latch_paddle && f.paddle_command < f.commands.size() && f.commands[f.paddle_command].kind == COMMAND_RECT) {
+        // same clamp as paddle_update()
+        const RenderCommand& paddle = f.commands[f.paddle_command];
+        double x = std::clamp<double>(input.mouse_x, GAME_AREA_START, GAME_AREA_END - paddle.w);
+        dx = x - paddle.x;
+        sampled = input.mouse_time;
+    }
+    replay_commands(f, paddle_begin, paddle_end, r, dx);
+    replay_commands(f, paddle_end, f.commands.size(), r);
+    return sampled;
+}
+
+
+int main(int argc, char** argv)
 {
     open_window("upDig", WINDOW_WIDTH, WINDOW_HEIGHT);
     GameState game = new_game_state();
-    game.terrain = grid_pattern(NUM_ROWS, NUM_COLS);
+    set_terrain(game, grid_pattern(NUM_ROWS, NUM_COLS, game.rng.terrain));
+    // new chunks come from a pregenerated corpus (tools/chunk_corpus.cpp) when one is passed as the first argument,
+    // otherwise they're generated
+    ChunkCorpus corpus = new_chunk_corpus();
+    if (argc > 1) {
+        if (open_chunk_corpus(corpus, argv[1])) {
+            game.corpus = &corpus;
+            write_line("chunk corpus " + std::string(argv[1]) + ": " + std::to_string(corpus.num_chunks) + " chunks");
+        } else {
+            write_line("couldn't open chunk corpus " + std::string(argv[1]) + ", generating chunks");
+        }
+    }
     hide_mouse();
+
+    // the simulation runs on its own thread, the main thread handles the window (which has to stay on it)
+    // and draws the latest frame the simulation published, so a slow update and a slow draw overlap
+    SimInput input;
+    input.mouse_x = static_cast<int>(mouse_x());
+    input.mouse_time = Clock::now().time_since_epoch().count();
+    input.actions = 0;
+    input.rewind = false;
+    input.quit = false;
+    input.draw_us = 0;
+    TripleBuffer<SimFrame> frames;
+    std::thread sim(simulate, std::ref(game), std::ref(input), std::ref(frames));
+
+    // DEBUG: F3 toggles the input-to-present latency report, F4 toggles late latching to compare
+    bool report_latency = false;
+    bool late_latch = true;
+    double latency_total_ms = 0, latency_max_ms = 0;
+    int latency_frames = 0;
+
+    Renderer renderer = new_window_renderer();
     while (!quit_requested())
     {
-        process_events();
-        if (game.status == PLAYING) {
-            // draw score top left in large text
-            // DEBUG
-            if (mouse_clicked(MOUSE_X1_BUTTON)) {
-                game.balls.push_back(new_ball({static_cast<double>(rng.randomInt(GAME_AREA_START, GAME_AREA_END)), static_cast<double>(GAME_AREA_HEIGHT-100)}, {3, -3}, 3, clr_ball_standard, ball_standard, 0, 1));
-            } else if (mouse_clicked(MOUSE_X2_BUTTON)) {
-                game.balls.push_back(new_ball({static_cast<double>(rng.randomInt(GAME_AREA_START, GAME_AREA_END)), static_cast<double>(GAME_AREA_HEIGHT-100)}, {3, -3}, 3, clr_ball_acid, ball_acid, 2, 700));
-            }
-            // END DEBUG
+        frames.acquire();
+        auto draw_start = Clock::now();
+        Clock::rep sampled = draw_frame(frames.front(), input, late_latch, renderer);
+        input.draw_us = std::chrono::duration<float, std::micro>(Clock::now() - draw_start).count();
+        refresh_screen(60);
 
-            update_global_state(game);
-            draw_global_state(game);
+        if (key_typed(F3_KEY)) report_latency = !report_latency;
+        if (key_typed(F4_KEY)) late_latch = !late_latch;
+        if (report_latency) {
+            // from sampling the mouse position on screen to refresh_screen() returning
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - Clock::time_point(Clock::duration(sampled))).count();
+            latency_total_ms += ms;
+            latency_max_ms = std::max(latency_max_ms, ms);
+            if (++latency_frames == LATENCY_REPORT_FRAMES) {
+                write_line("input-to-present latency (late latch " + std::string(late_latch ? "on" : "off") + "): mean "
+                    + std::to_string(latency_total_ms / latency_frames) + " ms, max " + std::to_string(latency_max_ms) + " ms");
+                latency_total_ms = latency_max_ms = 0;
+                latency_frames = 0;
+            }
         }
-        refresh_screen(60);
     }
+    input.quit = true;
+    sim.join();
+    close_chunk_corpus(corpus);
     return 0;
 }
@@ -0,0 +1,54 @@
+#include "include/quality.h"
+#include "include/globals.h"
+#include <algorithm>
+
+/**
+ * @brief Governor tuning: frames over budget before stepping down, frames under the recovery threshold before stepping up,
+ * the fraction of the budget to recover under, and the step sizes.
+ */
+static constexpr int FRAMES_BEFORE_DROP = 3;
+static constexpr int FRAMES_BEFORE_RAISE = 60;
+static constexpr int COOLDOWN_FRAMES = 15;
+static constexpr double RECOVER_BELOW = 0.6;
+static constexpr float DROP_FACTOR = 0.7f;
+static constexpr float RAISE_STEP = 0.05f;
+
+QualityGovernor new_quality_governor(double budget_us) {
+    QualityGovernor q;
+    q.budget_us = budget_us;
+    q.smoothed_us = 0;
+    q.level = 1.0f;
+    q.frames_over = 0;
+    q.frames_under = 0;
+    q.cooldown = 0;
+    return q;
+}
+
+float update_quality_governor(QualityGovernor& q, double frame_us) {
+    q.smoothed_us = q.smoothed_us == 0 ? frame_us : q.smoothed_us * 0.9 + frame_us * 0.1;
+    if (q.cooldown > 0) {
+        --q.cooldown;
+        return q.level;
+    }
+
+    if (q.smoothed_us > q.budget_us) {
+        q.frames_under = 0;
+        if (++q.frames_over >= FRAMES_BEFORE_DROP) {
+            q.level = std::max(MIN_QUALITY, q.level * DROP_FACTOR);
+            q.frames_over = 0;
+            q.cooldown = COOLDOWN_FRAMES;
+        }
+    } else if (q.smoothed_us < q.budget_us * RECOVER_BELOW) {
+        q.frames_over = 0;
+        if (++q.frames_under >= FRAMES_BEFORE_RAISE) {
+            q.level = std::min(1.0f, q.level + RAISE_STEP);
+            q.frames_under = 0;
+            q.cooldown = COOLDOWN_FRAMES;
+        }
+    } else {
+        // in the dead band, hold
+        q.frames_over = 0;
+        q.frames_under = 0;
+    }
+    return q.level;
+}
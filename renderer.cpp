@@ -0,0 +1,387 @@
+#include "include/renderer.h"
+#include "splashkit.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(RASTER_NO_SIMD)
+#include <emmintrin.h>
+#define RASTER_SSE2 1
+#endif
+
+// SPANS
+// Every fill comes down to horizontal spans of one colour. Opaque spans are plain stores, translucent spans blend
+// each channel as (src * a + dst * (255 - a)) / 255 (rounded). The SSE2 paths do 4 pixels at a time
+// and give the same pixels as the scalar fallback.
+
+/**
+ * @brief Pack a colour into an RGBA8 pixel.
+ */
+static uint32_t pack_color(color c) {
+    auto channel = [](float v) { return static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return channel(c.r) | channel(c.g) << 8 | channel(c.b) << 16 | channel(c.a) << 24;
+}
+
+/**
+ * @brief Round up to an int, for values in int range (std::ceil is a library call without SSE4.1).
+ */
+static inline int ceil_int(double v) {
+    int i = static_cast<int>(v);
+    return i + (i < v);
+}
+
+/**
+ * @brief Fill pixels [x0, x1) of a row with an opaque pixel.
+ */
+static void fill_span(uint32_t* row, int x0, int x1, uint32_t pixel) {
+    int x = x0;
+#ifdef RASTER_SSE2
+    __m128i p = _mm_set1_epi32(static_cast<int>(pixel));
+    for (; x + 4 <= x1; x += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), p);
+    }
+#endif
+    for (; x < x1; ++x) {
+        row[x] = pixel;
+    }
+}
+
+/**
+ * @brief Blend a pixel over pixels [x0, x1) of a row, with its alpha as the coverage.
+ * @details The source alpha channel is treated as opaque, so blending onto an opaque frame keeps it opaque.
+ */
+static void blend_span(uint32_t* row, int x0, int x1, uint32_t pixel) {
+    uint32_t a = pixel >> 24;
+    uint32_t inv = 255 - a;
+    uint32_t src[4] = {(pixel & 0xFF) * a, (pixel >> 8 & 0xFF) * a, (pixel >> 16 & 0xFF) * a, 255 * a};
+    int x = x0;
+#ifdef RASTER_SSE2
+    __m128i zero = _mm_setzero_si128();
+    short s0 = static_cast<short>(src[0]), s1 = static_cast<short>(src[1]), s2 = static_cast<short>(src[2]), s3 = static_cast<short>(src[3]);
+    __m128i src16 = _mm_setr_epi16(s0, s1, s2, s3, s0, s1, s2, s3);
+    __m128i inv16 = _mm_set1_epi16(static_cast<short>(inv));
+    __m128i round = _mm_set1_epi16(128);
+    auto blend8 = [&](__m128i dst) {
+        __m128i v = _mm_add_epi16(_mm_add_epi16(src16, _mm_mullo_epi16(dst, inv16)), round);
+        return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+    };
+    for (; x + 4 <= x1; x += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        __m128i lo = blend8(_mm_unpacklo_epi8(d, zero));
+        __m128i hi = blend8(_mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    // two channels at a time in 16-bit lanes of a 32-bit word, none of the sums carry across lanes
+    uint32_t src_rb = src[0] | src[2] << 16;
+    uint32_t src_ga = src[1] | src[3] << 16;
+    for (; x < x1; ++x) {
+        uint32_t d = row[x];
+        uint32_t rb = src_rb + (d & 0x00FF00FF) * inv + 0x00800080;
+        uint32_t ga = src_ga + (d >> 8 & 0x00FF00FF) * inv + 0x00800080;
+        rb = (rb + (rb >> 8 & 0x00FF00FF)) >> 8 & 0x00FF00FF;
+        ga = (ga + (ga >> 8 & 0x00FF00FF)) >> 8 & 0x00FF00FF;
+        row[x] = rb | ga << 8;
+    }
+}
+
+/**
+ * @brief Fill or blend a span, clipped to the framebuffer.
+ */
+static void draw_span(Framebuffer& fb, int y, int x0, int x1, uint32_t pixel) {
+    if (y < 0 || y >= fb.height) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, fb.width);
+    if (x0 >= x1) return;
+    uint32_t* row = fb.pixels.data() + static_cast<size_t>(y) * fb.width;
+    uint32_t a = pixel >> 24;
+    if (a == 255) {
+        fill_span(row, x0, x1, pixel);
+    } else if (a > 0) {
+        blend_span(row, x0, x1, pixel);
+    }
+}
+
+
+// RENDERER
+Renderer new_window_renderer() {
+    Renderer r = {};
+    r.backend = RENDER_WINDOW;
+    r.framebuffer = {0, 0, {}};
+    r.frame = nullptr;
+    return r;
+}
+
+Renderer new_software_renderer(int width, int height) {
+    Renderer r = {};
+    r.backend = RENDER_SOFTWARE;
+    r.framebuffer = {width, height, std::vector<uint32_t>(static_cast<size_t>(width) * height, 0)};
+    r.frame = nullptr;
+    return r;
+}
+
+Renderer new_recording_renderer() {
+    Renderer r = {};
+    r.backend = RENDER_RECORD;
+    r.framebuffer = {0, 0, {}};
+    r.frame = nullptr;
+    return r;
+}
+
+void begin_recording(Renderer& r, RenderFrame& frame) {
+    frame.commands.clear();
+    frame.text.clear();
+    frame.ribbon_points.clear();
+    std::fill(std::begin(frame.pass_begin), std::end(frame.pass_begin), 0);
+    std::fill(std::begin(frame.pass_end), std::end(frame.pass_end), 0);
+    frame.paddle_command = NO_COMMAND;
+    r.frame = &frame;
+}
+
+/**
+ * @brief Append a command to a recording renderer's frame.
+ */
+static void record(Renderer& r, RenderCommandKind kind, color c, double x, double y, double w, double h, uint32_t data = 0) {
+    r.frame->commands.push_back({kind, c, static_cast<float>(x), static_cast<float>(y), static_cast<float>(w), static_cast<float>(h), data});
+}
+
+static void fill_ribbon(Renderer& r, color c, const RibbonPoint* points, int count, double dx);
+
+void replay_frame(const RenderFrame& frame, Renderer& r) {
+    replay_commands(frame, 0, frame.commands.size(), r);
+}
+
+void replay_commands(const RenderFrame& frame, uint32_t begin, uint32_t end, Renderer& r, double dx) {
+    end = std::min<uint32_t>(end, frame.commands.size());
+    for (uint32_t i = begin; i < end; ++i) {
+        const RenderCommand& cmd = frame.commands[i];
+        switch (cmd.kind) {
+            case COMMAND_CLEAR: render_clear(r, cmd.clr); break;
+            case COMMAND_RECT: render_fill_rect(r, cmd.clr, cmd.x + dx, cmd.y, cmd.w, cmd.h); break;
+            case COMMAND_CIRCLE: render_fill_circle(r, cmd.clr, cmd.x + dx, cmd.y, cmd.w); break;
+            case COMMAND_TEXT: render_text(r, frame.text[cmd.data], cmd.clr, cmd.x + dx, cmd.y); break;
+            case COMMAND_RIBBON: fill_ribbon(r, cmd.clr, frame.ribbon_points.data() + cmd.data, static_cast<int>(cmd.w), dx); break;
+        }
+    }
+}
+
+void render_clear(Renderer& r, color c) {
+    ++r.draw_calls;
+    if (r.backend == RENDER_WINDOW) {
+        clear_screen(c);
+        return;
+    }
+    if (r.backend == RENDER_RECORD) {
+        record(r, COMMAND_CLEAR, c, 0, 0, 0, 0);
+        return;
+    }
+    fill_span(r.framebuffer.pixels.data(), 0, static_cast<int>(r.framebuffer.pixels.size()), pack_color(c));
+}
+
+void render_fill_rect(Renderer& r, color c, double x, double y, double width, double height) {
+    ++r.draw_calls;
+    if (r.backend == RENDER_WINDOW) {
+        fill_rectangle(c, x, y, width, height);
+        return;
+    }
+    if (r.backend == RENDER_RECORD) {
+        record(r, COMMAND_RECT, c, x, y, width, height);
+        return;
+    }
+    // pixel centres inside [x, x + width) x [y, y + height)
+    int x0 = static_cast<int>(std::ceil(x - 0.5));
+    int x1 = static_cast<int>(std::ceil(x + width - 0.5));
+    int y0 = std::max(static_cast<int>(std::ceil(y - 0.5)), 0);
+    int y1 = std::min(static_cast<int>(std::ceil(y + height - 0.5)), r.framebuffer.height);
+    uint32_t pixel = pack_color(c);
+    for (int py = y0; py < y1; ++py) {
+        draw_span(r.framebuffer, py, x0, x1, pixel);
+    }
+}
+
+void render_fill_circle(Renderer& r, color c, double x, double y, double radius) {
+    ++r.draw_calls;
+    if (r.backend == RENDER_WINDOW) {
+        fill_circle(c, x, y, radius);
+        return;
+    }
+    if (r.backend == RENDER_RECORD) {
+        record(r, COMMAND_CIRCLE, c, x, y, radius, 0);
+        return;
+    }
+    if (radius <= 0) return;
+    int y0 = std::max(static_cast<int>(std::ceil(y - radius - 0.5)), 0);
+    int y1 = std::min(static_cast<int>(std::floor(y + radius - 0.5)), r.framebuffer.height - 1);
+    uint32_t pixel = pack_color(c);
+    for (int py = y0; py <= y1; ++py) {
+        double dy = py + 0.5 - y;
+        double half = std::sqrt(std::max(radius * radius - dy * dy, 0.0));
+        int x0 = static_cast<int>(std::ceil(x - half - 0.5));
+        int x1 = static_cast<int>(std::floor(x + half - 0.5)) + 1;
+        draw_span(r.framebuffer, py, x0, x1, pixel);
+    }
+}
+
+/**
+ * @brief Fill a polygon, covering the pixels whose centres fall inside it.
+ * @details Each row is filled between the leftmost and rightmost edge crossings, which is exact for convex polygons.
+ * Edges are always walked top to bottom, so polygons sharing an edge split its pixels between them exactly.
+ */
+static void fill_polygon(Framebuffer& fb, const double* xs, const double* ys, int n, uint32_t pixel) {
+    constexpr int MAX_EDGES = 8;
+    struct Edge {
+        double top, bottom, x, slope;
+    };
+    Edge edges[MAX_EDGES];
+    int num_edges = 0;
+    double min_y = INFINITY, max_y = -INFINITY;
+    for (int i = 0; i < n && num_edges < MAX_EDGES; ++i) {
+        int j = (i + 1) % n;
+        int a = ys[i] <= ys[j] ? i : j;
+        int b = a == i ? j : i;
+        if (ys[a] == ys[b]) continue;
+        double slope = (xs[b] - xs[a]) / (ys[b] - ys[a]);
+        edges[num_edges++] = {ys[a], ys[b], xs[a] - ys[a] * slope, slope};
+        min_y = std::min(min_y, ys[a]);
+        max_y = std::max(max_y, ys[b]);
+    }
+    if (num_edges == 0) return;
+    int y0 = std::max(ceil_int(min_y - 0.5), 0);
+    int y1 = std::min(ceil_int(max_y - 0.5), fb.height);
+    for (int py = y0; py < y1; ++py) {
+        double yc = py + 0.5;
+        double left = INFINITY, right = -INFINITY;
+        for (int i = 0; i < num_edges; ++i) {
+            if (yc < edges[i].top || yc >= edges[i].bottom) continue;
+            double x = edges[i].x + yc * edges[i].slope;
+            left = std::min(left, x);
+            right = std::max(right, x);
+        }
+        if (left < right) {
+            draw_span(fb, py, ceil_int(left - 0.5), ceil_int(right - 0.5), pixel);
+        }
+    }
+}
+
+/**
+ * @brief Fill a ribbon moved along x, so replaying a moved ribbon doesn't need a moved copy of its points.
+ */
+static void fill_ribbon(Renderer& r, color c, const RibbonPoint* points, int count, double dx) {
+    if (count < 2) return;
+    if (r.backend == RENDER_RECORD) {
+        ++r.draw_calls;
+        uint32_t first = r.frame->ribbon_points.size();
+        r.frame->ribbon_points.insert(r.frame->ribbon_points.end(), points, points + count);
+        for (uint32_t i = first; i < r.frame->ribbon_points.size(); ++i) {
+            r.frame->ribbon_points[i].x += dx;
+        }
+        record(r, COMMAND_RIBBON, c, 0, 0, count, 0, first);
+        return;
+    }
+
+    // the edges of the strip at each point, along the normal of the line through its neighbours
+    auto edges = [&](int i, double& lx, double& ly, double& rx, double& ry) {
+        const RibbonPoint& prev = points[std::max(i - 1, 0)];
+        const RibbonPoint& next = points[std::min(i + 1, count - 1)];
+        double tx = next.x - prev.x, ty = next.y - prev.y;
+        double len = std::sqrt(tx * tx + ty * ty);
+        double nx = len > 0 ? -ty / len * points[i].half_width : 0;
+        double ny = len > 0 ? tx / len * points[i].half_width : 0;
+        lx = points[i].x + dx + nx;
+        ly = points[i].y + ny;
+        rx = points[i].x + dx - nx;
+        ry = points[i].y - ny;
+    };
+    double xs[4], ys[4];
+    edges(0, xs[0], ys[0], xs[3], ys[3]);
+    for (int i = 1; i < count; ++i) {
+        edges(i, xs[1], ys[1], xs[2], ys[2]);
+        color segment = c;
+        segment.a *= (points[i - 1].alpha + points[i].alpha) * 0.5f;
+        ++r.draw_calls;
+        if (r.backend == RENDER_WINDOW) {
+            fill_quad(segment, {xs[0], ys[0]}, {xs[1], ys[1]}, {xs[2], ys[2]}, {xs[3], ys[3]});
+        } else {
+            fill_polygon(r.framebuffer, xs, ys, 4, pack_color(segment));
+        }
+        // this segment's far edge is the next one's near edge
+        xs[0] = xs[1];
+        ys[0] = ys[1];
+        xs[3] = xs[2];
+        ys[3] = ys[2];
+    }
+}
+
+void render_fill_ribbon(Renderer& r, color c, const RibbonPoint* points, int count) {
+    fill_ribbon(r, c, points, count, 0);
+}
+
+void render_text(Renderer& r, const std::string& text, color c, double x, double y) {
+    if (r.backend == RENDER_WINDOW) {
+        ++r.draw_calls;
+        draw_text(text, c, x, y, option_to_screen());
+    } else if (r.backend == RENDER_RECORD) {
+        ++r.draw_calls;
+        r.frame->text.push_back(text);
+        record(r, COMMAND_TEXT, c, x, y, 0, 0, r.frame->text.size() - 1);
+    }
+}
+
+void render_mark_paddle(Renderer& r) {
+    if (r.backend == RENDER_RECORD) {
+        r.frame->paddle_command = r.frame->commands.size();
+    }
+}
+
+
+// TIMING
+void render_begin_pass(Renderer& r, RenderPass pass) {
+    if (r.backend == RENDER_RECORD) {
+        r.frame->pass_begin[pass] = r.frame->commands.size();
+    }
+    r.current_pass = pass;
+    r.pass_start = std::chrono::steady_clock::now();
+}
+
+void render_end_pass(Renderer& r) {
+    if (r.backend == RENDER_RECORD) {
+        r.frame->pass_end[r.current_pass] = r.frame->commands.size();
+    }
+    r.pass_us[r.current_pass] += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - r.pass_start).count();
+}
+
+void reset_render_stats(Renderer& r) {
+    std::fill(std::begin(r.pass_us), std::end(r.pass_us), 0.0);
+    r.draw_calls = 0;
+    r.frames = 0;
+}
+
+const char* render_pass_name(RenderPass pass) {
+    static const char* names[NUM_RENDER_PASSES] = {"background", "particles", "terrain", "powerups", "paddle", "balls"};
+    return names[pass];
+}
+
+
+// OUTPUT
+uint64_t frame_hash(const Framebuffer& fb) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (uint32_t pixel : fb.pixels) {
+        hash ^= pixel;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool write_ppm(const Framebuffer& fb, const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << fb.width << " " << fb.height << "\n255\n";
+    std::vector<uint8_t> rgb;
+    rgb.reserve(fb.pixels.size() * 3);
+    for (uint32_t pixel : fb.pixels) {
+        rgb.push_back(pixel & 0xFF);
+        rgb.push_back(pixel >> 8 & 0xFF);
+        rgb.push_back(pixel >> 16 & 0xFF);
+    }
+    file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+    return file.good();
+}
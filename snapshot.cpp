@@ -0,0 +1,460 @@
+#include "include/snapshot.h"
+#include "include/globals.h"
+#include "include/state_init.h"
+#include "include/state_management.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static const char SNAPSHOT_MAGIC[4] = {'B', 'R', 'K', 'N'};
+
+/**
+ * @brief Size of a saved block: hit points, y position and y velocity.
+ */
+static constexpr size_t SNAPSHOT_BLOCK_SIZE = sizeof(uint8_t) + 2 * sizeof(float);
+
+// WRITE
+template<typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void put_color(std::vector<uint8_t>& out, const color& c) {
+    put<float>(out, c.r);
+    put<float>(out, c.g);
+    put<float>(out, c.b);
+    put<float>(out, c.a);
+}
+
+static void put_rng(std::vector<uint8_t>& out, const XOR& rng) {
+    uint32_t state[XOR::STATE_WORDS];
+    rng.saveState(state);
+    for (uint32_t word : state) {
+        put<uint32_t>(out, word);
+    }
+}
+
+static void put_particle(std::vector<uint8_t>& out, const Particle& p) {
+    put<double>(out, p.pos.x);
+    put<double>(out, p.pos.y);
+    put<double>(out, p.vel.x);
+    put<double>(out, p.vel.y);
+    put_color(out, p.clr);
+    put<uint8_t>(out, p.size);
+    put<uint16_t>(out, p.ttl);
+    put<uint32_t>(out, p.birth);
+}
+
+/**
+ * @brief Write a queue of cells, leaving out the cells pushed off the bottom (they are skipped without costing budget).
+ */
+static void put_cell_queue(std::vector<uint8_t>& out, const std::deque<ivec2>& queue) {
+    auto in_window = [](ivec2 cell) { return cell.y < NUM_ROWS; };
+    put<uint32_t>(out, std::count_if(queue.begin(), queue.end(), in_window));
+    for (const auto& cell : queue) {
+        if (!in_window(cell)) continue;
+        put<uint8_t>(out, cell.x);
+        put<uint8_t>(out, cell.y);
+    }
+}
+
+static void put_ball(std::vector<uint8_t>& out, const Ball& b) {
+    put<double>(out, b.pos.x);
+    put<double>(out, b.pos.y);
+    put<double>(out, b.vel.x);
+    put<double>(out, b.vel.y);
+    put<uint8_t>(out, b.size);
+    put_color(out, b.clr);
+    put<uint8_t>(out, b.effect);
+    put<uint8_t>(out, b.active);
+    put<uint8_t>(out, b.ttl_type);
+    put<int32_t>(out, b.ttl);
+    put<uint32_t>(out, b.birth);
+    put<uint32_t>(out, b.trail.size());
+    for (uint32_t i = 0; i < b.trail.size(); ++i) {
+        put<double>(out, b.trail[i].x);
+        put<double>(out, b.trail[i].y);
+    }
+}
+
+void save_snapshot(const GameState& g, std::vector<uint8_t>& out) {
+    out.clear();
+    for (char c : SNAPSHOT_MAGIC) {
+        put<char>(out, c);
+    }
+    put<uint16_t>(out, SNAPSHOT_VERSION);
+    put<uint8_t>(out, NUM_ROWS);
+    put<uint8_t>(out, NUM_COLS);
+    put<uint64_t>(out, g.corpus ? g.corpus->hash : 0);
+
+    put<uint8_t>(out, g.status);
+    put<int32_t>(out, g.score);
+    put<uint32_t>(out, g.tick);
+    put<uint8_t>(out, g.ball_collisions);
+    put_rng(out, g.rng.terrain);
+    put_rng(out, g.rng.gameplay);
+    put_rng(out, g.rng.cosmetic);
+
+    put<int32_t>(out, g.paddle.x);
+    put<int32_t>(out, g.paddle.y);
+    put<int32_t>(out, g.paddle.width);
+    put<int32_t>(out, g.paddle.height);
+    put_color(out, g.paddle.clr);
+    put<uint8_t>(out, g.paddle.autopilot);
+
+    // terrain: occupancy + dying bitboards, then the fields of those blocks in row-major order
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        put<RowBits>(out, g.occupancy[y]);
+        put<RowBits>(out, g.dying[y]);
+        put<RowBits>(out, g.connectivity_dirty[y]);
+        put<RowBits>(out, g.erosion_pending[y]);
+        put<RowBits>(out, g.eroded[y]);
+        put<RowBits>(out, g.explosive[y]);
+        put<RowBits>(out, g.explosion_pending[y]);
+    }
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        for (RowBits present = g.occupancy[y] | g.dying[y]; present; present &= present - 1) {
+            int i = cell_index(lowest_bit(present), y);
+            put<uint8_t>(out, g.terrain.hp[i]);
+            put<float>(out, g.terrain.y[i]);
+            put<float>(out, g.terrain.y_vel[i]);
+        }
+    }
+
+    put_cell_queue(out, g.erosion_queue);
+    put_cell_queue(out, g.explosion_queue);
+
+    put<uint32_t>(out, g.balls.size());
+    for (const auto& b : g.balls) {
+        put_ball(out, b);
+    }
+    put<uint32_t>(out, g.particles.size());
+    for (const auto& p : g.particles) {
+        put_particle(out, p);
+    }
+
+    put<uint32_t>(out, g.powerups.size());
+    for (const auto& p : g.powerups) {
+        put<double>(out, p.pos.x);
+        put<double>(out, p.pos.y);
+        put<double>(out, p.vel.x);
+        put<double>(out, p.vel.y);
+        put<uint8_t>(out, p.size);
+        put_color(out, p.clr);
+        put<uint8_t>(out, p.kind);
+    }
+    put<uint32_t>(out, g.powerup_trail.size());
+    for (uint32_t i = 0; i < g.powerup_trail.size(); ++i) {
+        put_particle(out, g.powerup_trail[i]);
+    }
+}
+
+// READ
+/**
+ * @brief A SnapshotReader is a bounds-checked cursor over snapshot bytes.
+ * @details Reads past the end return zeroes and set ok to false, so the loader checks once at the end.
+ */
+struct SnapshotReader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+    bool ok;
+};
+
+template<typename T>
+static T get(SnapshotReader& r) {
+    T value{};
+    if (r.offset + sizeof(T) > r.size) {
+        r.ok = false;
+        return value;
+    }
+    std::memcpy(&value, r.data + r.offset, sizeof(T));
+    r.offset += sizeof(T);
+    return value;
+}
+
+static color get_color(SnapshotReader& r) {
+    color c;
+    c.r = get<float>(r);
+    c.g = get<float>(r);
+    c.b = get<float>(r);
+    c.a = get<float>(r);
+    return c;
+}
+
+static void get_rng(SnapshotReader& r, XOR& rng) {
+    uint32_t state[XOR::STATE_WORDS];
+    for (uint32_t& word : state) {
+        word = get<uint32_t>(r);
+    }
+    rng.loadState(state);
+}
+
+static Particle get_particle(SnapshotReader& r) {
+    Particle p;
+    p.pos.x = get<double>(r);
+    p.pos.y = get<double>(r);
+    p.vel.x = get<double>(r);
+    p.vel.y = get<double>(r);
+    p.clr = get_color(r);
+    p.size = get<uint8_t>(r);
+    p.ttl = get<uint16_t>(r);
+    p.birth = get<uint32_t>(r);
+    // a particle lives at least one update, its age is divided by its ttl
+    if (p.ttl == 0) {
+        r.ok = false;
+    }
+    return p;
+}
+
+static Ball get_ball(SnapshotReader& r) {
+    Ball b;
+    b.pos.x = get<double>(r);
+    b.pos.y = get<double>(r);
+    b.vel.x = get<double>(r);
+    b.vel.y = get<double>(r);
+    b.size = get<uint8_t>(r);
+    b.clr = get_color(r);
+    uint8_t effect = get<uint8_t>(r);
+    b.effect = static_cast<BallEffectId>(effect);
+    b.active = get<uint8_t>(r);
+    b.ttl_type = get<uint8_t>(r);
+    b.ttl = get<int32_t>(r);
+    b.birth = get<uint32_t>(r);
+    if (effect >= NUM_BALL_EFFECTS) {
+        r.ok = false;
+    }
+    uint32_t trail_size = get<uint32_t>(r);
+    if (trail_size > BALL_TRAIL_LENGTH) {
+        r.ok = false;
+    }
+    for (uint32_t i = 0; i < trail_size && r.ok; ++i) {
+        double x = get<double>(r);
+        double y = get<double>(r);
+        b.trail.push({x, y});
+    }
+    return b;
+}
+
+/**
+ * @brief Read a queue of cells, each of which must be in the grid and marked in its pending bitboard.
+ * @details A cell is pending exactly while it is queued, so the queue also has to mark every pending cell, once.
+ */
+static void get_cell_queue(SnapshotReader& r, std::deque<ivec2>& queue, const Occupancy& pending) {
+    Occupancy queued = {};
+    uint32_t count = get<uint32_t>(r);
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        int x = get<uint8_t>(r);
+        int y = get<uint8_t>(r);
+        if (x >= NUM_COLS || y >= NUM_ROWS || !(pending[y] & cell_bit(x)) || (queued[y] & cell_bit(x))) {
+            r.ok = false;
+            return;
+        }
+        queued[y] |= cell_bit(x);
+        queue.push_back({x, y});
+    }
+    if (queued != pending) {
+        r.ok = false;
+    }
+}
+
+static void get_balls(SnapshotReader& r, SlotMap<Ball>& balls) {
+    balls.clear();
+    uint32_t count = get<uint32_t>(r);
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        balls.insert(get_ball(r));
+    }
+}
+
+bool load_snapshot(GameState& g, const uint8_t* data, size_t size) {
+    SnapshotReader r = {data, size, 0, true};
+    if (size < 8 || std::memcmp(data, SNAPSHOT_MAGIC, 4) != 0) {
+        return false;
+    }
+    r.offset = 4;
+    if (get<uint16_t>(r) != SNAPSHOT_VERSION || get<uint8_t>(r) != NUM_ROWS || get<uint8_t>(r) != NUM_COLS) {
+        return false;
+    }
+    // new chunks come from the corpus, a game continued with another one (or none) would get different terrain
+    if (get<uint64_t>(r) != (g.corpus ? g.corpus->hash : 0)) {
+        return false;
+    }
+
+    // decode into a scratch state so a bad snapshot leaves g untouched, then move it across
+    GameState s;
+    uint8_t status = get<uint8_t>(r);
+    s.status = static_cast<GameStatus>(status);
+    s.score = get<int32_t>(r);
+    s.tick = get<uint32_t>(r);
+    uint8_t ball_collisions = get<uint8_t>(r);
+    s.ball_collisions = ball_collisions;
+    if (status >= NUM_GAME_STATUSES || ball_collisions > 1) {
+        return false;
+    }
+    get_rng(r, s.rng.terrain);
+    get_rng(r, s.rng.gameplay);
+    get_rng(r, s.rng.cosmetic);
+
+    s.paddle.x = get<int32_t>(r);
+    s.paddle.y = get<int32_t>(r);
+    s.paddle.width = get<int32_t>(r);
+    s.paddle.height = get<int32_t>(r);
+    s.paddle.clr = get_color(r);
+    s.paddle.autopilot = get<uint8_t>(r);
+    s.paddle.target_x = s.paddle.x; // input, set again before the next update
+
+    Occupancy present;
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        s.occupancy[y] = get<RowBits>(r);
+        s.dying[y] = get<RowBits>(r);
+        s.connectivity_dirty[y] = get<RowBits>(r);
+        s.erosion_pending[y] = get<RowBits>(r);
+        s.eroded[y] = get<RowBits>(r);
+        s.explosive[y] = get<RowBits>(r);
+        s.explosion_pending[y] = get<RowBits>(r);
+        present[y] = s.occupancy[y] | s.dying[y];
+        if ((s.occupancy[y] & s.dying[y]) || present[y] >> NUM_COLS) {
+            return false;
+        }
+        // explosive blocks keep the bit until their debris is gone, every other bitboard is checked against the grid width
+        // (the pending ones against their queues below)
+        if ((s.explosive[y] & ~present[y]) || (s.connectivity_dirty[y] | s.erosion_pending[y] | s.eroded[y]) >> NUM_COLS) {
+            return false;
+        }
+    }
+
+    // the block records are fixed size, skip them until the rest of the snapshot has been validated
+    size_t blocks_offset = r.offset;
+    size_t num_blocks = 0;
+    for (RowBits row : present) {
+        num_blocks += bit_count(row);
+    }
+    r.offset += num_blocks * SNAPSHOT_BLOCK_SIZE;
+    if (r.offset > size) {
+        return false;
+    }
+
+    get_cell_queue(r, s.erosion_queue, s.erosion_pending);
+    get_cell_queue(r, s.explosion_queue, s.explosion_pending);
+
+    get_balls(r, s.balls);
+    uint32_t num_particles = get<uint32_t>(r);
+    for (uint32_t i = 0; i < num_particles && r.ok; ++i) {
+        s.particles.insert(get_particle(r));
+    }
+
+    uint32_t num_powerups = get<uint32_t>(r);
+    if (num_powerups > MAX_POWERUPS) {
+        return false;
+    }
+    s.powerups.reserve(MAX_POWERUPS);
+    for (uint32_t i = 0; i < num_powerups && r.ok; ++i) {
+        PowerUp p;
+        p.pos.x = get<double>(r);
+        p.pos.y = get<double>(r);
+        p.vel.x = get<double>(r);
+        p.vel.y = get<double>(r);
+        p.size = get<uint8_t>(r);
+        p.clr = get_color(r);
+        uint8_t kind = get<uint8_t>(r);
+        p.kind = static_cast<PowerUpKind>(kind);
+        if (kind >= NUM_POWERUP_KINDS) {
+            return false;
+        }
+        s.powerups.insert(p);
+    }
+    uint32_t num_trail = get<uint32_t>(r);
+    if (num_trail > POWERUP_TRAIL_CAPACITY) {
+        return false;
+    }
+    for (uint32_t i = 0; i < num_trail && r.ok; ++i) {
+        s.powerup_trail.push(get_particle(r));
+    }
+
+    if (!r.ok || r.offset != size) {
+        return false;
+    }
+
+    // read the blocks back, a block with hit points left must be occupied and a dying one must have none
+    s.terrain = new_terrain();
+    r.offset = blocks_offset;
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        for (RowBits cells = present[y]; cells; cells &= cells - 1) {
+            int x = lowest_bit(cells);
+            int i = cell_index(x, y);
+            s.terrain.hp[i] = get<uint8_t>(r);
+            s.terrain.y[i] = get<float>(r);
+            s.terrain.y_vel[i] = get<float>(r);
+            bool occupied = s.occupancy[y] & cell_bit(x);
+            if (s.terrain.hp[i] > MAX_BLOCK_HP || (s.terrain.hp[i] != 0) != occupied) {
+                return false;
+            }
+        }
+    }
+
+    s.quality = g.quality; // a runtime setting, not part of the game
+    s.ball_grid = std::move(g.ball_grid); // scratch space, rebuilt every update
+    // the timers are derived, reschedule every particle and timed ball (reusing the running game's slots)
+    s.particle_timers = std::move(g.particle_timers);
+    s.particle_timers.clear();
+    for (uint32_t i = 0; i < s.particles.size(); ++i) {
+        s.particle_timers.schedule(s.particles.handle_at(i), s.particles[i].birth + s.particles[i].ttl, s.tick);
+    }
+    s.ball_timers = std::move(g.ball_timers);
+    s.ball_timers.clear();
+    for (uint32_t i = 0; i < s.balls.size(); ++i) {
+        if (s.balls[i].ttl_type == 2) {
+            s.ball_timers.schedule(s.balls.handle_at(i), s.balls[i].birth + s.balls[i].ttl, s.tick);
+        }
+    }
+    s.corpus = g.corpus;
+    rebuild_exposed(s);
+    rebuild_block_sets(s);
+
+    g = std::move(s);
+    return true;
+}
+
+bool save_snapshot_file(const GameState& g, const std::string& path) {
+    std::vector<uint8_t> bytes;
+    save_snapshot(g, bytes);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    return file.good();
+}
+
+bool load_snapshot_file(GameState& g, const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return load_snapshot(g, bytes.data(), bytes.size());
+}
+
+
+// RING
+SnapshotRing new_snapshot_ring(int capacity) {
+    SnapshotRing ring;
+    ring.frames.resize(capacity);
+    ring.head = 0;
+    ring.count = 0;
+    return ring;
+}
+
+void snapshot_ring_push(SnapshotRing& ring, const GameState& g) {
+    if (ring.frames.empty()) return;
+    save_snapshot(g, ring.frames[ring.head]);
+    ring.head = (ring.head + 1) % ring.frames.size();
+    ring.count = std::min<int>(ring.count + 1, ring.frames.size());
+}
+
+bool snapshot_ring_rewind(SnapshotRing& ring, GameState& g) {
+    if (ring.count == 0) return false;
+    ring.head = (ring.head + ring.frames.size() - 1) % ring.frames.size();
+    --ring.count;
+    const auto& frame = ring.frames[ring.head];
+    return load_snapshot(g, frame.data(), frame.size());
+}
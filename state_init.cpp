@@ -1,34 +1,88 @@
 #include "include/globals.h"
 #include "include/state_init.h"
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 
-GameState new_game_state() {
+GameState new_game_state(uint32_t seed) {
     GameState game;
+    game.rng = new_rng_streams(seed);
     game.score = 0;
+    game.tick = 0;
     game.status = PLAYING;
-    game.terrain;
+    game.terrain = new_terrain();
+    game.occupancy.fill(0);
+    game.exposed.fill(0);
+    game.animating.fill(0);
+    game.dying.fill(0);
+    game.connectivity_dirty.fill(0);
+    game.erosion_queue = {};
+    game.erosion_pending.fill(0);
+    game.eroded.fill(0);
+    game.explosive.fill(0);
+    game.explosion_queue = {};
+    game.explosion_pending.fill(0);
     game.paddle = new_paddle();
-    game.balls = {};
-    game.particles = {};
+    game.balls.clear();
+    game.ball_grid = new_ball_grid();
+    game.ball_collisions = true;
+    game.ball_timers.clear();
+    game.particles.clear();
+    game.particle_timers.clear();
+    game.expired_particles = {};
+    game.powerups.clear();
+    game.powerups.reserve(MAX_POWERUPS);
+    game.powerup_trail.clear();
+    game.corpus = nullptr;
+    game.quality = 1.0f;
     return game;
 }
 
+RngStreams new_rng_streams(uint32_t seed) {
+    XOR root(seed);
+    RngStreams streams;
+    streams.terrain = root.split();
+    streams.gameplay = root.split();
+    streams.cosmetic = root.split();
+    return streams;
+}
+
 void reset_game_state(GameState& game) {
     game.score = 0;
     game.status = PLAYING;
-    game.terrain.clear();
+    game.terrain = new_terrain();
+    game.occupancy.fill(0);
+    game.exposed.fill(0);
+    game.animating.fill(0);
+    game.dying.fill(0);
+    game.connectivity_dirty.fill(0);
+    game.erosion_queue = {};
+    game.erosion_pending.fill(0);
+    game.eroded.fill(0);
+    game.explosive.fill(0);
+    game.explosion_queue = {};
+    game.explosion_pending.fill(0);
     game.paddle = new_paddle();
-    game.balls = {};
-    game.particles = {};
+    game.balls.clear();
+    game.ball_grid = new_ball_grid();
+    game.ball_collisions = true;
+    game.ball_timers.clear();
+    game.particles.clear();
+    game.particle_timers.clear();
+    game.expired_particles = {};
+    game.powerups.clear();
+    game.powerup_trail.clear();
 }
 
 Paddle new_paddle() {
     Paddle paddle;
     paddle.x = WINDOW_WIDTH / 2;
     paddle.y = WINDOW_HEIGHT - 50;
-    paddle.width = 100;
+    paddle.width = INITIAL_PADDLE_WIDTH;
     paddle.height = 10;
     paddle.clr = clr_paddle;
+    paddle.target_x = paddle.x;
+    paddle.autopilot = false;
     return paddle;
 }
 
@@ -39,12 +93,11 @@ Particle new_particle(point_2d pos, vector_2d vel, color clr, int size, int ttl)
     particle.size = size;
     particle.clr = clr;
     particle.ttl = ttl;
-    particle.max_ttl = ttl;
-    particle.original_size = size;
+    particle.birth = 0;
     return particle;
 }
 
-Ball new_ball(point_2d pos, vector_2d vel, int size, color clr, BallEffect effect, int ttl_type, int ttl) {
+Ball new_ball(point_2d pos, vector_2d vel, int size, color clr, BallEffectId effect, int ttl_type, int ttl) {
     Ball ball;
     ball.pos = pos;
     ball.vel = vel;
@@ -55,21 +108,57 @@ Ball new_ball(point_2d pos, vector_2d vel, int size, color clr, BallEffect effec
     ball.trail = {};
     ball.ttl_type = ttl_type;
     ball.ttl = ttl;
-    ball.max_ttl = ttl;
-    assert(effect && "BallEffect must be initialized with a valid function");
+    ball.birth = 0;
+    assert(effect < NUM_BALL_EFFECTS && "BallEffectId must name an entry in BALL_EFFECTS");
     return ball;
 }
 
-Block new_block(point_2d pos, point_2d target_pos, ivec2 grid_pos, int width, int height, color c) {
-    Block block;
-    block.pos = pos;
-    block.target_pos = target_pos;
-    block.grid_pos = grid_pos;
-    block.width = width;
-    block.height = height;
-    block.clr = c;
-    block.active = true;
-    block.y_vel = 0.0;
-    return block;
+PowerUp new_powerup(point_2d pos, vector_2d vel, int size, color clr, PowerUpKind kind) {
+    PowerUp powerup;
+    powerup.pos = pos;
+    powerup.vel = vel;
+    powerup.size = size;
+    powerup.clr = clr;
+    powerup.kind = kind;
+    assert(kind < NUM_POWERUP_KINDS && "PowerUpKind must name an entry in POWERUP_EFFECTS");
+    return powerup;
 }
 
+Terrain new_terrain() {
+    Terrain terrain;
+    terrain.hp.fill(0);
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        for (int x = 0; x < NUM_COLS; ++x) {
+            terrain.y[cell_index(x, y)] = y * BLOCK_HEIGHT;
+        }
+    }
+    terrain.y_vel.fill(0);
+    return terrain;
+}
+
+Chunk new_chunk(int rows) {
+    Chunk chunk;
+    chunk.rows = rows;
+    chunk.hp.assign(rows * NUM_COLS, 0);
+    return chunk;
+}
+
+ChunkCorpus new_chunk_corpus() {
+    ChunkCorpus corpus;
+    corpus.data = nullptr;
+    corpus.size = 0;
+    corpus.mapped = false;
+    corpus.num_chunks = 0;
+    std::fill(std::begin(corpus.first), std::end(corpus.first), 0);
+    std::fill(std::begin(corpus.count), std::end(corpus.count), 0);
+    corpus.index = nullptr;
+    corpus.chunk_data = nullptr;
+    corpus.hash = 0;
+    return corpus;
+}
+
+BallGrid new_ball_grid() {
+    BallGrid grid;
+    grid.cell_start.assign(BALL_GRID_CELLS + 1, 0);
+    return grid;
+}
@@ -0,0 +1,83 @@
+#include "include/stencils.h"
+#include "include/state_management.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+Stencil new_stencil(StencilShape shape, int radius) {
+    radius = clamp(radius, 0, MAX_STENCIL_RADIUS);
+    Stencil s = {};
+    s.radius = radius;
+    // compare squared distances against (r + 0.5)^2 so circles round out instead of leaving single cell nubs at the axes
+    int outer = radius * radius + radius;
+    int inner = (radius - 1) * (radius - 1) + (radius - 1);
+    for (int dy = -radius; dy <= radius; ++dy) {
+        RowBits row = 0;
+        for (int dx = -radius; dx <= radius; ++dx) {
+            int dist = dx * dx + dy * dy;
+            bool in = false;
+            switch (shape) {
+                case STENCIL_SQUARE: in = true; break;
+                case STENCIL_CIRCLE: in = dist <= outer; break;
+                case STENCIL_DIAMOND: in = std::abs(dx) + std::abs(dy) <= radius; break;
+                case STENCIL_RING: in = dist <= outer && (radius == 0 || dist > inner); break;
+                default: break;
+            }
+            if (in) {
+                row |= cell_bit(dx + radius);
+            }
+        }
+        s.rows[dy + radius] = row;
+    }
+    return s;
+}
+
+const Stencil& get_stencil(StencilShape shape, int radius) {
+    using StencilLibrary = std::array<std::array<Stencil, MAX_STENCIL_RADIUS + 1>, NUM_STENCIL_SHAPES>;
+    // built once on first use (function statics initialise thread safely)
+    static const StencilLibrary library = []() {
+        StencilLibrary lib;
+        for (int shape = 0; shape < NUM_STENCIL_SHAPES; ++shape) {
+            for (int r = 0; r <= MAX_STENCIL_RADIUS; ++r) {
+                lib[shape][r] = new_stencil(static_cast<StencilShape>(shape), r);
+            }
+        }
+        return lib;
+    }();
+    return library[shape][clamp(radius, 0, MAX_STENCIL_RADIUS)];
+}
+
+RowBits stencil_row_mask(const Stencil& s, int dy, int center_x) {
+    RowBits row = s.rows[dy + s.radius];
+    int shift = center_x - s.radius;
+    if (shift <= -32 || shift >= 32) return 0;
+    return (shift >= 0 ? row << shift : row >> -shift) & FULL_ROW;
+}
+
+int apply_stencil(GameState& g, const Stencil& s, ivec2 center) {
+    int cleared = 0;
+    int first = std::max(center.y - s.radius, 0);
+    int last = std::min(center.y + s.radius, NUM_ROWS - 1);
+    for (int y = first; y <= last; ++y) {
+        for (RowBits hit = g.occupancy[y] & stencil_row_mask(s, y - center.y, center.x); hit; hit &= hit - 1) {
+            deactivate_block(g, {lowest_bit(hit), y});
+            ++cleared;
+        }
+    }
+    return cleared;
+}
+
+int queue_erosion(GameState& g, const Stencil& s, ivec2 center) {
+    int queued = 0;
+    int first = std::max(center.y - s.radius, 0);
+    int last = std::min(center.y + s.radius, NUM_ROWS - 1);
+    for (int y = first; y <= last; ++y) {
+        RowBits fresh = g.occupancy[y] & ~g.erosion_pending[y] & stencil_row_mask(s, y - center.y, center.x);
+        g.erosion_pending[y] |= fresh;
+        for (; fresh; fresh &= fresh - 1) {
+            g.erosion_queue.push_back({lowest_bit(fresh), y});
+            ++queued;
+        }
+    }
+    return queued;
+}
@@ -4,64 +4,58 @@
 #include "include/terrain_patterns.h"
 #include <cmath>
 #include "include/state_init.h"
+#include "include/noise.h"
+#include <algorithm>
+#include <tuple>
 
 
-Grid grid_pattern(int rows, int cols) {
-    Grid chunk;
+Chunk grid_pattern(int rows, int cols, XOR& rng) {
+    Chunk chunk = new_chunk(rows);
     int mod_x = rng.randomInt(2, 20);
     int mod_y = rng.randomInt(2, 20);
     int mod_thresh = rng.randomInt(1, std::min(mod_x, mod_y));
     int x_start = (NUM_COLS - cols) / 2;
     int x_end = x_start + cols;
     for (int y = 0; y < rows; ++y) {
-        Row new_row;
         for (int x = 0; x < NUM_COLS; ++x) {
             bool edge =is_edge({x, y}, {x_start, 0}, {x_end, rows}, 2);
             bool in = x >= x_start && x < x_end;
-            if ((x % mod_x < mod_thresh || y % mod_y < mod_thresh || edge) && in) {
-                point_2d pos = {static_cast<double>(TERRAIN_OFFSET + x * BLOCK_WIDTH), 0.0f};
-                point_2d target_pos = {pos.x, static_cast<double>(y * BLOCK_HEIGHT)};
-                ivec2 grid_pos = {x, y};
-                new_row.push_back(std::make_unique<Block>(new_block(pos, target_pos, grid_pos, BLOCK_WIDTH, BLOCK_HEIGHT, clr_block)));
-            } else {
-                new_row.push_back(nullptr);
+            bool column = x % mod_x < mod_thresh;
+            bool row = y % mod_y < mod_thresh;
+            if ((column || row || edge) && in) {
+                // the lattice crossings take two hits
+                chunk.hp[cell_index(x, y)] = column && row && !edge ? 2 : 1;
             }
         }
-        chunk.push_back(std::move(new_row));
     }
     return chunk;
 }
 
 
-Grid sine_pattern(int rows, int cols) {
+Chunk sine_pattern(int rows, int cols, XOR& rng) {
     bool x_ax = rng.chance(0.5);
     float scale = rng.randomFloat(0.1, 1.0);
-    Grid chunk;
+    Chunk chunk = new_chunk(rows);
     int x_start = (NUM_COLS - cols) / 2;
     int x_end = x_start + cols;
     for (int y = 0; y < rows; ++y) {
-        Row new_row;
         for (int x = 0; x < NUM_COLS; ++x) {
             bool edge =is_edge({x, y}, {x_start, 0}, {x_end, rows}, 2);
             bool in = x >= x_start && x < x_end;
-            if (((x_ax ? std::sin(static_cast<float>(x) * scale) : std::sin(static_cast<float>(y) * scale)) > 0.5f || edge) && in) {
-                point_2d pos = {static_cast<double>(TERRAIN_OFFSET + x * BLOCK_WIDTH), 0.0};
-                point_2d target_pos = {pos.x, static_cast<double>(y * BLOCK_HEIGHT)};
-                ivec2 grid_pos = {x, y};
-                new_row.push_back(std::make_unique<Block>(new_block(pos, target_pos, grid_pos, BLOCK_WIDTH, BLOCK_HEIGHT, clr_block)));
-            } else {
-                new_row.push_back(nullptr);
+            float wave = x_ax ? std::sin(static_cast<float>(x) * scale) : std::sin(static_cast<float>(y) * scale);
+            if ((wave > 0.5f || edge) && in) {
+                // the crests of the bands take two hits
+                chunk.hp[cell_index(x, y)] = wave > 0.9f && !edge ? 2 : 1;
             }
         }
-        chunk.push_back(std::move(new_row));
     }
     return chunk;
 }
 
 
 // Function to generate a grid pattern with circles
-Grid circle_lattice_pattern(int rows, int cols) {
-    Grid chunk;
+Chunk circle_lattice_pattern(int rows, int cols, XOR& rng) {
+    Chunk chunk = new_chunk(rows);
     int x_start = (NUM_COLS - cols) / 2;
     int x_end = x_start + cols;
 
@@ -88,7 +82,6 @@ Grid circle_lattice_pattern(int rows, int cols) {
     }
 
     for (int y = 0; y < rows; ++y) {
-        Row new_row;
         for (int x = 0; x < NUM_COLS; ++x) {
             bool in_circle = false;
             for (const auto& [centroid_x, centroid_y, radius] : centroids) {
@@ -103,47 +96,128 @@ Grid circle_lattice_pattern(int rows, int cols) {
             bool edge =is_edge({x, y}, {x_start, 0}, {x_end, rows}, 2);
             bool in = x >= x_start && x < x_end;
             if ((in_circle || edge) && in) {
-                point_2d pos = {static_cast<double>(TERRAIN_OFFSET + x * BLOCK_WIDTH), 0.0};
-                point_2d target_pos = {pos.x, static_cast<double>(y * BLOCK_HEIGHT)};
-                ivec2 grid_pos = {x, y};
-                new_row.push_back(std::make_unique<Block>(new_block(pos, target_pos, grid_pos, BLOCK_WIDTH, BLOCK_HEIGHT, clr_block)));
-            } else {
-                new_row.push_back(nullptr);
+                // the rings take two hits
+                chunk.hp[cell_index(x, y)] = in_circle && !edge ? 2 : 1;
             }
         }
-        chunk.push_back(std::move(new_row));
     }
     return chunk;
 }
 
 
-Grid sine_landscape(int rows, int cols) {
+Chunk sine_landscape(int rows, int cols, XOR& rng) {
     bool x_ax = rng.chance(0.5);
     float scale = rng.randomFloat(0.01, 0.1);
-    Grid chunk;
+    Chunk chunk = new_chunk(rows);
     int x_start = (NUM_COLS - cols) / 2;
     int x_end = x_start + cols;
     for (int y = 0; y < rows; ++y) {
-        Row new_row;
         for (int x = 0; x < NUM_COLS; ++x) {
             bool edge =is_edge({x, y}, {x_start, 0}, {x_end, rows}, 2);
             bool in = x >= x_start && x < x_end;
-            bool sine = std::sin(static_cast<float>(x) * scale) * rows <= y;
+            float surface = std::sin(static_cast<float>(x) * scale) * rows;
+            bool sine = surface <= y;
             if ((sine || edge) && in) {
-                point_2d pos = {static_cast<double>(TERRAIN_OFFSET + x * BLOCK_WIDTH), 0.0};
-                point_2d target_pos = {pos.x, static_cast<double>(y * BLOCK_HEIGHT)};
-                ivec2 grid_pos = {x, y};
-                new_row.push_back(std::make_unique<Block>(new_block(pos, target_pos, grid_pos, BLOCK_WIDTH, BLOCK_HEIGHT, clr_block)));
-            } else {
-                new_row.push_back(nullptr);
+                // the ground hardens with depth below its surface
+                int depth = sine && !edge ? static_cast<int>(y - surface) : 0;
+                chunk.hp[cell_index(x, y)] = std::min(1 + depth / 8, MAX_BLOCK_HP);
             }
         }
-        chunk.push_back(std::move(new_row));
     }
     return chunk;
 }
 
 
+// NOISE PATTERNS
+// These evaluate a noise field a row at a time and threshold it into row masks, instead of testing cell by cell.
+
+/**
+ * @brief Get the cells of a row that are on the edge of a rectangle, the row-wise is_edge().
+ */
+static RowBits edge_row_mask(int y, ivec2 start, ivec2 end, int thresh) {
+    if (y < start.y + thresh || y >= end.y - thresh) {
+        return span_mask(start.x, end.x - 1);
+    }
+    return span_mask(start.x, start.x + thresh - 1) | span_mask(end.x - thresh, end.x - 1);
+}
+
+/**
+ * @brief Set the hit points of the cells of a chunk row in a mask.
+ */
+static void fill_cells(Chunk& chunk, int y, RowBits cells, uint8_t hp) {
+    for (; cells; cells &= cells - 1) {
+        chunk.hp[cell_index(lowest_bit(cells), y)] = hp;
+    }
+}
+
+Chunk cave_pattern(int rows, int cols, XOR& rng) {
+    float frequency = rng.randomFloat(0.08f, 0.2f);
+    NoiseParams noise = {rng.randomWord(), frequency, frequency, 3, 0.5f, false};
+    float threshold = rng.randomFloat(0.4f, 0.55f);
+    Chunk chunk = new_chunk(rows);
+    int x_start = (NUM_COLS - cols) / 2;
+    int x_end = x_start + cols;
+    RowBits in = span_mask(x_start, x_end - 1);
+    float values[NUM_COLS];
+    for (int y = 0; y < rows; ++y) {
+        noise_row(noise, y, values, NUM_COLS);
+        RowBits edge = edge_row_mask(y, {x_start, 0}, {x_end, rows}, 2);
+        RowBits rock = threshold_mask(values, NUM_COLS, threshold) & in;
+        // the rock far from the cave walls takes two hits
+        RowBits hard = threshold_mask(values, NUM_COLS, threshold + 0.15f) & in & ~edge;
+        fill_cells(chunk, y, rock | edge, 1);
+        fill_cells(chunk, y, hard, 2);
+    }
+    return chunk;
+}
+
+Chunk vein_pattern(int rows, int cols, XOR& rng) {
+    float frequency = rng.randomFloat(0.08f, 0.16f);
+    NoiseParams noise = {rng.randomWord(), frequency, frequency, 2, 0.3f, true};
+    float threshold = rng.randomFloat(0.7f, 0.78f);
+    Chunk chunk = new_chunk(rows);
+    int x_start = (NUM_COLS - cols) / 2;
+    int x_end = x_start + cols;
+    RowBits in = span_mask(x_start, x_end - 1);
+    float values[NUM_COLS];
+    for (int y = 0; y < rows; ++y) {
+        noise_row(noise, y, values, NUM_COLS);
+        RowBits edge = edge_row_mask(y, {x_start, 0}, {x_end, rows}, 2);
+        RowBits veins = threshold_mask(values, NUM_COLS, threshold) & in;
+        // the cores of the veins take two hits
+        RowBits cores = threshold_mask(values, NUM_COLS, (1.0f + threshold) * 0.5f) & in & ~edge;
+        fill_cells(chunk, y, veins | edge, 1);
+        fill_cells(chunk, y, cores, 2);
+    }
+    return chunk;
+}
+
+Chunk strata_pattern(int rows, int cols, XOR& rng) {
+    NoiseParams noise = {rng.randomWord(), rng.randomFloat(0.05f, 0.15f), 0.1f, 2, 0.5f, false};
+    int thickness = rng.randomInt(3, 6);
+    float warp = rng.randomFloat(2.0f, 6.0f);
+    Chunk chunk = new_chunk(rows);
+    int x_start = (NUM_COLS - cols) / 2;
+    int x_end = x_start + cols;
+    float values[NUM_COLS];
+    for (int y = 0; y < rows; ++y) {
+        noise_row(noise, y, values, NUM_COLS);
+        // the noise bends the layers, which cycle through a gap and rock of increasing hardness
+        for (int x = x_start; x < x_end; ++x) {
+            int band = static_cast<int>((y + warp * values[x]) / thickness);
+            chunk.hp[cell_index(x, y)] = band % (MAX_BLOCK_HP + 1);
+        }
+        fill_cells(chunk, y, edge_row_mask(y, {x_start, 0}, {x_end, rows}, 2), 1);
+    }
+    return chunk;
+}
+
+
+Chunk generate_chunk(PatternKind pattern, int rows, int cols, XOR& rng) {
+    return PATTERNS[pattern](rows, cols, rng);
+}
+
+
 bool is_edge(ivec2 pos, ivec2 start, ivec2 end, int thresh) {
     return pos.x < start.x + thresh || pos.x >= end.x - thresh || pos.y < start.y + thresh || pos.y >= end.y - thresh;
 }
@@ -1,143 +1,339 @@
 #include "include/state_management.h"
 #include "include/terrain_patterns.h"
+#include "include/chunk_corpus.h"
 #include "include/globals.h"
-#include <stack>
+#include "include/state_init.h"
+#include "include/stencils.h"
+#include <algorithm>
 
 
 int count_non_empty_rows(GameState& g) {
     int non_empty_rows = 0;
-    for (const auto& row : g.terrain) {
-        if (std::any_of(row.begin(), row.end(), [](const std::unique_ptr<Block>& block) { return block != nullptr; })) {
-            ++non_empty_rows;
-        }
+    for (RowBits row : g.occupancy) {
+        non_empty_rows += row != 0;
     }
     return non_empty_rows;
 }
 
-void shift_rows_down(GameState& g, int num_rows_to_shift) {
-    if (num_rows_to_shift <= 0) return;
+RowBits row_occupancy(const Terrain& terrain, int row) {
+    RowBits bits = 0;
+    for (int x = 0; x < NUM_COLS; ++x) {
+        bits |= RowBits(terrain.hp[cell_index(x, row)] != 0) << x;
+    }
+    return bits;
+}
 
-    // Shift rows down
-    for (int y = g.terrain.size() - 1; y >= num_rows_to_shift; --y) {
-        g.terrain[y] = std::move(g.terrain[y - num_rows_to_shift]);
-        for (auto &block : g.terrain[y]) {
-            if (block) {
-                block->target_pos.y += BLOCK_HEIGHT * num_rows_to_shift;
-                block->grid_pos.y += num_rows_to_shift;
+void rebuild_occupancy(GameState& g) {
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        g.occupancy[y] = row_occupancy(g.terrain, y);
+        g.explosive[y] &= g.occupancy[y] | g.dying[y];
+        g.eroded[y] &= g.dying[y];
+    }
+    rebuild_exposed(g);
+    rebuild_block_sets(g);
+    invalidate_connectivity(g);
+}
+
+void rebuild_block_sets(GameState& g) {
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        g.animating[y] = 0;
+        for (RowBits cells = g.occupancy[y]; cells; cells &= cells - 1) {
+            int x = lowest_bit(cells);
+            if (g.terrain.y[cell_index(x, y)] < y * BLOCK_HEIGHT) {
+                g.animating[y] |= cell_bit(x);
             }
         }
     }
+}
+
+/**
+ * @brief Copy the rows of a chunk to the top of the terrain, its blocks starting at the top of the screen.
+ *
+ * @param g The game state.
+ * @param chunk The chunk.
+ */
+static void place_chunk(GameState& g, const Chunk& chunk) {
+    for (int y = 0; y < chunk.rows && y < NUM_ROWS; ++y) {
+        for (int x = 0; x < NUM_COLS; ++x) {
+            int i = cell_index(x, y);
+            g.terrain.hp[i] = std::min<uint8_t>(chunk.hp[i], MAX_BLOCK_HP);
+            g.terrain.y[i] = 0;
+            g.terrain.y_vel[i] = 0;
+        }
+        g.occupancy[y] = row_occupancy(g.terrain, y);
+        // row 0 is already in place, every other block falls in
+        g.animating[y] = y > 0 ? g.occupancy[y] : 0;
+        g.dying[y] = 0;
+        g.explosive[y] = 0;
+        g.eroded[y] = 0;
+    }
+}
+
+void set_terrain(GameState& g, const Chunk& chunk) {
+    g.terrain = new_terrain();
+    g.occupancy.fill(0);
+    g.dying.fill(0);
+    g.explosive.fill(0);
+    g.eroded.fill(0);
+    place_chunk(g, chunk);
+    rebuild_occupancy(g);
+}
+
+void rebuild_exposed(GameState& g) {
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        RowBits above = y > 0 ? g.occupancy[y - 1] : FULL_ROW;
+        RowBits below = y < NUM_ROWS - 1 ? g.occupancy[y + 1] : 0;
+        g.exposed[y] = exposed_cells(above, g.occupancy[y], below);
+    }
+}
+
+void invalidate_connectivity(GameState& g) {
+    g.connectivity_dirty.fill(FULL_ROW);
+}
+
+bool damage_block(GameState& g, ivec2 grid_pos) {
+    uint8_t& hp = g.terrain.hp[cell_index(grid_pos.x, grid_pos.y)];
+    if (hp > 1) {
+        --hp;
+        return false;
+    }
+    deactivate_block(g, grid_pos);
+    return true;
+}
+
+void deactivate_block(GameState& g, ivec2 grid_pos) {
+    RowBits bit = cell_bit(grid_pos.x);
+    g.terrain.hp[cell_index(grid_pos.x, grid_pos.y)] = 0;
+    g.dying[grid_pos.y] |= bit;
+    g.animating[grid_pos.y] &= ~bit;
+    g.occupancy[grid_pos.y] &= ~bit;
+    if (g.explosive[grid_pos.y] & bit) {
+        queue_explosion(g, grid_pos); // the explosive bit stays until the block is destroyed, for its debris
+    }
+    g.connectivity_dirty[grid_pos.y] |= bit;
+    // the hole uncovers its neighbours
+    RowBits around = bit | (bit << 1) | (bit >> 1);
+    g.exposed[grid_pos.y] = (g.exposed[grid_pos.y] | around) & g.occupancy[grid_pos.y];
+    if (grid_pos.y > 0) g.exposed[grid_pos.y - 1] |= g.occupancy[grid_pos.y - 1] & around;
+    if (grid_pos.y < NUM_ROWS - 1) g.exposed[grid_pos.y + 1] |= g.occupancy[grid_pos.y + 1] & around;
+}
+
+void shift_rows_down(GameState& g, int num_rows_to_shift) {
+    if (num_rows_to_shift <= 0) return;
+
+    // Shift rows down, each block keeping its screen position and falling to its new row
+    int shift_cells = num_rows_to_shift * NUM_COLS;
+    std::copy_backward(g.terrain.hp.begin(), g.terrain.hp.end() - shift_cells, g.terrain.hp.end());
+    std::copy_backward(g.terrain.y.begin(), g.terrain.y.end() - shift_cells, g.terrain.y.end());
+    std::copy_backward(g.terrain.y_vel.begin(), g.terrain.y_vel.end() - shift_cells, g.terrain.y_vel.end());
+    for (int y = NUM_ROWS - 1; y >= num_rows_to_shift; --y) {
+        g.occupancy[y] = g.occupancy[y - num_rows_to_shift];
+        g.dying[y] = g.dying[y - num_rows_to_shift];
+        g.explosive[y] = g.explosive[y - num_rows_to_shift];
+        g.eroded[y] = g.eroded[y - num_rows_to_shift];
+        // every block in a moved row starts falling to its new target
+        g.animating[y] = g.occupancy[y];
+    }
     // Clear the top rows
+    std::fill(g.terrain.hp.begin(), g.terrain.hp.begin() + shift_cells, 0);
     for (int y = 0; y < num_rows_to_shift; ++y) {
-        for (auto &block : g.terrain[y]) {
-            block.reset(); // Set each element to nullptr
-        }
+        g.occupancy[y] = 0;
+        g.animating[y] = 0;
+        g.dying[y] = 0;
+        g.explosive[y] = 0;
+        g.eroded[y] = 0;
     }
+
+    // Queued erosion moves down with its rows
+    for (int y = NUM_ROWS - 1; y >= 0; --y) {
+        g.erosion_pending[y] = y >= num_rows_to_shift ? g.erosion_pending[y - num_rows_to_shift] : 0;
+    }
+    for (auto& cell : g.erosion_queue) {
+        cell.y += num_rows_to_shift; // cells pushed off the bottom are skipped by update_erosion()
+    }
+    // and so do queued explosions
+    for (int y = NUM_ROWS - 1; y >= 0; --y) {
+        g.explosion_pending[y] = y >= num_rows_to_shift ? g.explosion_pending[y - num_rows_to_shift] : 0;
+    }
+    for (auto& cell : g.explosion_queue) {
+        cell.y += num_rows_to_shift; // cells pushed off the bottom are skipped by update_explosions()
+    }
+    rebuild_exposed(g);
+    invalidate_connectivity(g);
 }
 
 
-void add_new_chunk(GameState& g, int num_rows, std::function<Grid(int, int)> pattern_func) {
-    int num_cols = rng.randomInt(20, NUM_COLS);
-    Grid new_chunk = pattern_func(num_rows, num_cols);
+void add_new_chunk(GameState& g, int num_rows, PatternKind pattern) {
+    // Add the new chunk at the top, from the corpus when it has one this size
+    Chunk chunk;
+    if (!g.corpus || !random_corpus_chunk(*g.corpus, num_rows, g.rng.terrain, chunk)) {
+        int num_cols = g.rng.terrain.randomInt(20, NUM_COLS);
+        chunk = generate_chunk(pattern, num_rows, num_cols, g.rng.terrain);
+    }
+    place_chunk(g, chunk);
 
-    // Add the new chunk at the top
+    // a few blocks of every chunk are explosive
     for (int y = 0; y < num_rows; ++y) {
-        g.terrain[y] = std::move(new_chunk[y]);
-        for (auto &block : g.terrain[y]) {
-            if (block) {
-                block->target_pos.y = y * BLOCK_HEIGHT;
+        for (RowBits cells = g.occupancy[y]; cells; cells &= cells - 1) {
+            int x = lowest_bit(cells);
+            if (g.rng.terrain.chance(EXPLOSIVE_BLOCK_CHANCE)) {
+                g.explosive[y] |= cell_bit(x);
             }
         }
     }
+    rebuild_exposed(g);
+    invalidate_connectivity(g);
 }
 
 
-void update_terrain(GameState& g) {
+void update_erosion(GameState& g) {
+    for (int budget = ACID_CELLS_PER_TICK; budget > 0 && !g.erosion_queue.empty(); g.erosion_queue.pop_front()) {
+        ivec2 cell = g.erosion_queue.front();
+        if (cell.y >= NUM_ROWS) continue;
+        g.erosion_pending[cell.y] &= ~cell_bit(cell.x);
+        // the block may have been destroyed some other way while it was queued
+        if (!(g.occupancy[cell.y] & cell_bit(cell.x))) continue;
+        g.eroded[cell.y] |= cell_bit(cell.x); // debris comes off acid coloured
+        deactivate_block(g, cell);
+        --budget;
+    }
+}
 
-    // Check if the bottom row is completely empty
-    bool bottom_row_empty = true;
-    for (auto& block : g.terrain.back()) {
-        if (block) {
-            bottom_row_empty = false;
-            break;
+
+void queue_explosion(GameState& g, ivec2 cell) {
+    RowBits bit = cell_bit(cell.x);
+    if (g.explosion_pending[cell.y] & bit) return;
+    g.explosion_pending[cell.y] |= bit;
+    g.explosion_queue.push_back(cell);
+}
+
+
+void update_explosions(GameState& g) {
+    const Stencil& blast = get_stencil(STENCIL_CIRCLE, EXPLOSIVE_BLOCK_RADIUS);
+    for (int budget = EXPLOSIONS_PER_TICK; budget > 0 && !g.explosion_queue.empty(); g.explosion_queue.pop_front()) {
+        ivec2 cell = g.explosion_queue.front();
+        if (cell.y >= NUM_ROWS) continue;
+        g.explosion_pending[cell.y] &= ~cell_bit(cell.x);
+        // explosive blocks caught in the blast queue up behind the explosions already waiting (breadth first)
+        apply_stencil(g, blast, cell);
+        --budget;
+
+        float vel[20 * 2];
+        int n = particle_budget(g, 20);
+        int ttl = particle_ttl(g, 40);
+        g.rng.cosmetic.fillFloats(vel, n * 2, -3.0f, 3.0f);
+        point_2d pos = {static_cast<double>(TERRAIN_OFFSET + cell.x * BLOCK_WIDTH + BLOCK_WIDTH / 2),
+                        static_cast<double>(cell.y * BLOCK_HEIGHT + BLOCK_HEIGHT / 2)};
+        for (int i = 0; i < n; ++i) {
+            spawn_particle(g, new_particle(pos, {vel[i * 2], vel[i * 2 + 1]}, clr_block_explosive, 2, ttl));
         }
     }
+}
+
+
+void update_terrain(GameState& g) {
 
     // Shift rows down and add a new chunk at the top if the bottom row is empty
-    if (bottom_row_empty) {
+    if (g.occupancy.back() == 0) {
         int non_empty_rows = count_non_empty_rows(g);
         int num_rows_to_shift = NUM_ROWS - non_empty_rows;
 
         if (num_rows_to_shift > 0) {
-            PatternFunc pattern_func = rng.choose({sine_landscape, grid_pattern, sine_pattern, circle_lattice_pattern}); //
+            static constexpr PatternKind patterns[] = {PATTERN_SINE_LANDSCAPE, PATTERN_GRID, PATTERN_SINE, PATTERN_CIRCLE_LATTICE,
+                                                       PATTERN_CAVE, PATTERN_VEIN, PATTERN_STRATA};
+            PatternKind pattern = g.rng.terrain.choose(patterns);
             shift_rows_down(g, num_rows_to_shift);
-            add_new_chunk(g, num_rows_to_shift, pattern_func);
+            add_new_chunk(g, num_rows_to_shift, pattern);
         }
     }
 
+    // Eat away at the cells queued by acid balls
+    update_erosion(g);
+
+    // Set off the explosions destroyed explosive blocks have queued
+    update_explosions(g);
+
     // Deactivate disconnected clusters
     deactivate_disconnected_clusters(g);
 
-    // Update each block
-    for (auto& row : g.terrain) {
-        for (auto& block : row) {
-            if (block) {
-                block_update(*block, g);
-                if (!block->active) {
-                    block.reset(); // Automatically deletes the block and sets the pointer to nullptr
-                }
+    // Update the falling and dying blocks, settled blocks have nothing to do
+    for (int y = 0; y < NUM_ROWS; ++y) {
+        for (RowBits cells = g.animating[y] | g.dying[y]; cells; cells &= cells - 1) {
+            int x = lowest_bit(cells);
+            block_update(g, {x, y});
+            if (g.terrain.y[cell_index(x, y)] >= y * BLOCK_HEIGHT) {
+                g.animating[y] &= ~cell_bit(x);
             }
         }
     }
+    g.dying.fill(0);
 }
 
 
-void dfs_mark_reachable(GameState& g, int row, int col, std::vector<std::vector<bool>>& visited) {
-    std::stack<std::pair<int, int>> stack;
-    stack.push({row, col});
-
-    while (!stack.empty()) {
-        auto pair = stack.top();
-        int r = pair.first;
-        int c = pair.second;
-        stack.pop();
+void flood_fill(const Occupancy& occupied, const Occupancy& seed, Occupancy& filled) {
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        filled[row] = seed[row] & occupied[row];
+    }
 
-        if (r < 0 || r >= g.terrain.size() || c < 0 || c >= g.terrain[r].size() || !g.terrain[r][c] || visited[r][c]) {
-            continue;
+    // Alternate downward and upward sweeps, each row picking up cells connected to its filled neighbours
+    // and spreading them along the row, until a full pass adds nothing.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int i = 0; i < NUM_ROWS; ++i) {
+                int row = pass == 0 ? i : NUM_ROWS - 1 - i;
+                RowBits row_seed = filled[row];
+                if (row > 0) row_seed |= filled[row - 1];
+                if (row < NUM_ROWS - 1) row_seed |= filled[row + 1];
+                RowBits row_filled = fill_row(row_seed, occupied[row]);
+                if (row_filled != filled[row]) {
+                    filled[row] = row_filled;
+                    changed = true;
+                }
+            }
         }
-
-        visited[r][c] = true;
-
-        // Check adjacent blocks
-        stack.push({r - 1, c}); // above
-        stack.push({r + 1, c}); // below
-        stack.push({r, c - 1}); // left
-        stack.push({r, c + 1}); // right
     }
 }
 
+void mark_reachable(const Occupancy& occupied, Occupancy& reachable) {
+    Occupancy top = {};
+    top[0] = occupied[0];
+    flood_fill(occupied, top, reachable);
+}
+
 /**
- * @brief Uses DFS to check if blocks are not connected to top row (have been shaved off main body of terrain)
+ * @brief Uses the occupancy bitboard to check if blocks are not connected to top row (have been shaved off main body of terrain)
  * and deactivates them.
- * @visited array is used to mark blocks that are reachable from the top row (is a boolean map of terrain grid).
+ * @details Removing cells can only cut off the pieces of terrain they were touching, so only the components
+ * containing a neighbour of a cell removed since the last pass are checked.
  * @param g The game state.
  */
 void deactivate_disconnected_clusters(GameState& g) {
-    std::vector<std::vector<bool>> visited(NUM_ROWS, std::vector<bool>(NUM_COLS, false));
-
-    // Mark all reachable blocks starting from the top row
-    for (int col = 0; col < NUM_COLS; ++col) {
-        if (g.terrain[0][col]) {
-            dfs_mark_reachable(g, 0, col, visited);
-        }
+    // occupied neighbours of the removed cells
+    Occupancy seed;
+    bool any_seed = false;
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        RowBits around = g.connectivity_dirty[row] | (g.connectivity_dirty[row] << 1) | (g.connectivity_dirty[row] >> 1);
+        if (row > 0) around |= g.connectivity_dirty[row - 1];
+        if (row < NUM_ROWS - 1) around |= g.connectivity_dirty[row + 1];
+        seed[row] = around & g.occupancy[row];
+        any_seed |= seed[row] != 0;
     }
+    g.connectivity_dirty.fill(0);
+    if (!any_seed) return;
 
-    // Deactivate all unvisited (disconnected) blocks
+    // the pieces of terrain touching the removed cells, and the parts of them still reachable from the top row
+    Occupancy region, reachable;
+    flood_fill(g.occupancy, seed, region);
+    mark_reachable(region, reachable);
+
+    // Deactivate all unreachable (disconnected) blocks
     for (int row = 0; row < NUM_ROWS; ++row) {
-        for (int col = 0; col < NUM_COLS; ++col) {
-            if (g.terrain[row][col] && !visited[row][col]) {
-                g.terrain[row][col]->active = false;
-            }
+        for (RowBits orphans = region[row] & ~reachable[row]; orphans; orphans &= orphans - 1) {
+            deactivate_block(g, {lowest_bit(orphans), row});
         }
     }
+    // whole components were removed, which can't cut anything else off
+    g.connectivity_dirty.fill(0);
 }
@@ -0,0 +1,102 @@
+/**
+ * @brief Ball-ball collision benchmark.
+ * @details For each ball count, scatters the balls over an empty game area and moves them for a number of ticks,
+ * bouncing off all four walls. Every tick it finds the touching pairs by testing every pair of balls, then runs
+ * collide_balls() on the same positions (which also resolves them). It prints the time each takes per tick and the number of ticks where the
+ * two disagreed on the pairs.
+ *
+ * Build from the repo root alongside the game sources (everything except program.cpp):
+ *     skm clang++ -O2 tools/ball_bench.cpp $(ls *.cpp | grep -v program.cpp) -o ball_bench
+ *
+ * Usage:
+ *     ./ball_bench [ticks=100] [seed=1] [counts=10,100,500,1000,2000,5000]
+ */
+
+#include "../include/globals.h"
+#include "../include/types.h"
+#include "../include/state_init.h"
+#include "../include/state_management.h"
+#include "../include/ball_grid.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+using Pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+/**
+ * @brief Find the touching pairs by testing every pair of balls, the way find_ball_pairs() avoids.
+ */
+static void find_ball_pairs_naive(const SlotMap<Ball>& balls, Pairs& pairs) {
+    pairs.clear();
+    for (uint32_t i = 0; i < balls.size(); ++i) {
+        for (uint32_t j = i + 1; j < balls.size(); ++j) {
+            if (balls_touch(balls[i], balls[j])) {
+                pairs.push_back({i, j});
+            }
+        }
+    }
+}
+
+/**
+ * @brief Move the balls one tick, bouncing them off the walls and the bottom of the game area (there's no paddle).
+ */
+static void move_balls(GameState& g) {
+    for (Ball& b : g.balls) {
+        b.pos.x += b.vel.x;
+        b.pos.y += b.vel.y;
+        if (b.pos.y > GAME_AREA_HEIGHT - b.size) {
+            b.pos.y = GAME_AREA_HEIGHT - b.size;
+            b.vel.y *= -1;
+        }
+        ball_check_wall_collision(b);
+    }
+}
+
+int main(int argc, char** argv) {
+    int ticks = argc > 1 ? std::atoi(argv[1]) : 100;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 0)) : 1;
+    std::string counts_arg = argc > 3 ? argv[3] : "10,100,500,1000,2000,5000";
+    std::vector<int> counts;
+    for (size_t start = 0; start < counts_arg.size();) {
+        size_t end = counts_arg.find(',', start);
+        end = end == std::string::npos ? counts_arg.size() : end;
+        counts.push_back(std::atoi(counts_arg.substr(start, end - start).c_str()));
+        start = end + 1;
+    }
+
+    printf("%d ticks, seed %u\n", ticks, seed);
+    printf("%8s %14s %14s %10s %12s %10s\n", "balls", "grid (us)", "naive (us)", "speedup", "pairs/tick", "mismatch");
+    for (int n : counts) {
+        GameState g = new_game_state(seed);
+        g.balls.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            point_2d pos = {g.rng.gameplay.randomFloat(GAME_AREA_START + 3, GAME_AREA_END - 4), g.rng.gameplay.randomFloat(3, GAME_AREA_HEIGHT - 3)};
+            vector_2d vel = {g.rng.gameplay.randomFloat(-3, 3), g.rng.gameplay.randomFloat(-3, 3)};
+            spawn_ball(g, new_ball(pos, vel, 3, clr_ball_standard, EFFECT_STANDARD, 0, 0));
+        }
+
+        Pairs naive;
+        double grid_us = 0, naive_us = 0;
+        long long pairs = 0;
+        int mismatches = 0;
+        for (int t = 0; t < ticks; ++t) {
+            move_balls(g);
+
+            auto start = std::chrono::steady_clock::now();
+            find_ball_pairs_naive(g.balls, naive);
+            naive_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            pairs += collide_balls(g);
+            grid_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            mismatches += g.ball_grid.pairs != naive;
+        }
+        printf("%8d %14.1f %14.1f %9.1fx %12.1f %10d\n", n, grid_us / ticks, naive_us / ticks, naive_us / grid_us,
+               static_cast<double>(pairs) / ticks, mismatches);
+    }
+    return 0;
+}
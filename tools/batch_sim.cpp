@@ -0,0 +1,186 @@
+/**
+ * @brief Headless batch simulator for balancing and load testing.
+ * @details Runs many independent game states across all cores, each with its own rng and an autopilot paddle,
+ * and prints aggregate score, ball, particle and tick cost stats.
+ *
+ * Build from the repo root alongside the game sources (everything except program.cpp):
+ *     skm clang++ -O2 tools/batch_sim.cpp $(ls *.cpp | grep -v program.cpp) -o batch_sim
+ *
+ * Usage:
+ *     ./batch_sim [instances=1000] [ticks=3600] [start_balls=3] [seed=1] [threads=all] [corpus]
+ *
+ * With a chunk corpus file (tools/chunk_corpus.cpp) every instance draws its new chunks from it.
+ */
+
+#include "../include/globals.h"
+#include "../include/types.h"
+#include "../include/state_management.h"
+#include "../include/state_init.h"
+#include "../include/terrain_patterns.h"
+#include "../include/ball_effects.h"
+#include "../include/chunk_corpus.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A SimConfig holds the parameters shared by every instance in a batch.
+ */
+struct SimConfig {
+    int instances;
+    int ticks;
+    int start_balls;
+    uint32_t seed;
+    int threads;
+    const ChunkCorpus* corpus;
+};
+
+/**
+ * @brief A SimResult holds the stats gathered from a single simulated game.
+ */
+struct SimResult {
+    int score;
+    int ticks_run;
+    int peak_balls;
+    int peak_particles;
+    double mean_tick_us;
+    double max_tick_us;
+};
+
+/**
+ * @brief Seed for an instance, spread so neighbouring instance indices don't get correlated xorshift streams.
+ *
+ * @param base The batch seed.
+ * @param index The instance index.
+ * @return uint32_t The (non-zero) instance seed.
+ */
+static uint32_t instance_seed(uint32_t base, int index) {
+    uint32_t s = base + static_cast<uint32_t>(index) * 0x9E3779B9u;
+    s ^= s >> 16;
+    s *= 0x85EBCA6Bu;
+    s ^= s >> 13;
+    return s ? s : 0x77777777;
+}
+
+/**
+ * @brief Play one game with the autopilot paddle until it runs out of balls or ticks.
+ *
+ * @param seed The seed the game's rng streams are split from.
+ * @param config The batch configuration.
+ * @return SimResult The stats for the game.
+ */
+static SimResult run_instance(uint32_t seed, const SimConfig& config) {
+    GameState game = new_game_state(seed);
+    set_terrain(game, grid_pattern(NUM_ROWS, NUM_COLS, game.rng.terrain));
+    game.paddle.autopilot = true;
+    game.corpus = config.corpus;
+    for (int i = 0; i < config.start_balls; ++i) {
+        Ball b = roll_ball(game.rng.gameplay);
+        b.pos = {static_cast<double>(game.paddle.x + game.paddle.width / 2), static_cast<double>(game.paddle.y - 20)};
+        spawn_ball(game, b);
+    }
+
+    SimResult result = {};
+    double total_us = 0;
+    for (int t = 0; t < config.ticks && !game.balls.empty(); ++t) {
+        auto start = std::chrono::steady_clock::now();
+        update_global_state(game);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        total_us += us;
+        result.max_tick_us = std::max(result.max_tick_us, us);
+        result.peak_balls = std::max(result.peak_balls, static_cast<int>(game.balls.size()));
+        result.peak_particles = std::max(result.peak_particles, static_cast<int>(game.particles.size()));
+        ++result.ticks_run;
+    }
+    result.score = game.score;
+    result.mean_tick_us = result.ticks_run ? total_us / result.ticks_run : 0;
+    return result;
+}
+
+/**
+ * @brief Get the value at a percentile of a sorted sample.
+ */
+template<typename T>
+static T percentile(const std::vector<T>& sorted, double p) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5))];
+}
+
+/**
+ * @brief Print min / mean / p50 / p95 / max of a stat across all instances.
+ */
+template<typename T>
+static void print_stat(const char* name, std::vector<T> values) {
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (T v : values) sum += v;
+    printf("%-16s min %10.1f  mean %10.1f  p50 %10.1f  p95 %10.1f  max %10.1f\n", name,
+           static_cast<double>(values.front()), sum / values.size(), static_cast<double>(percentile(values, 0.5)),
+           static_cast<double>(percentile(values, 0.95)), static_cast<double>(values.back()));
+}
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    config.instances = argc > 1 ? std::atoi(argv[1]) : 1000;
+    config.ticks = argc > 2 ? std::atoi(argv[2]) : 3600;
+    config.start_balls = argc > 3 ? std::atoi(argv[3]) : 3;
+    config.seed = argc > 4 ? static_cast<uint32_t>(std::strtoul(argv[4], nullptr, 0)) : 1;
+    config.threads = argc > 5 ? std::atoi(argv[5]) : static_cast<int>(std::thread::hardware_concurrency());
+    config.threads = std::max(1, std::min(config.threads, config.instances));
+    if (config.instances <= 0) return 0;
+    ChunkCorpus corpus = new_chunk_corpus();
+    config.corpus = nullptr;
+    if (argc > 6) {
+        if (!open_chunk_corpus(corpus, argv[6])) {
+            fprintf(stderr, "couldn't open chunk corpus %s\n", argv[6]);
+            return 1;
+        }
+        config.corpus = &corpus;
+    }
+
+    std::vector<SimResult> results(config.instances);
+    std::atomic<int> next_instance{0};
+    auto worker = [&]() {
+        for (int i = next_instance++; i < config.instances; i = next_instance++) {
+            results[i] = run_instance(instance_seed(config.seed, i), config);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<int> score, ticks, peak_balls, peak_particles;
+    std::vector<double> mean_tick, max_tick;
+    long long total_ticks = 0;
+    for (const auto& r : results) {
+        score.push_back(r.score);
+        ticks.push_back(r.ticks_run);
+        peak_balls.push_back(r.peak_balls);
+        peak_particles.push_back(r.peak_particles);
+        mean_tick.push_back(r.mean_tick_us);
+        max_tick.push_back(r.max_tick_us);
+        total_ticks += r.ticks_run;
+    }
+
+    printf("%d instances x %d ticks, %d start balls, seed %u, %d threads%s\n",
+           config.instances, config.ticks, config.start_balls, config.seed, config.threads, config.corpus ? ", chunk corpus" : "");
+    printf("%.2fs wall, %.0f ticks/s\n\n", wall_s, total_ticks / wall_s);
+    print_stat("score", score);
+    print_stat("ticks survived", ticks);
+    print_stat("peak balls", peak_balls);
+    print_stat("peak particles", peak_particles);
+    print_stat("mean tick (us)", mean_tick);
+    print_stat("max tick (us)", max_tick);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @brief Offline chunk corpus generator.
+ * @details Generates chunks of every size (1 to NUM_ROWS rows) from the terrain patterns and writes them into a chunk corpus file
+ * (chunk_corpus.h), which the game opens at startup when given its path (./program chunks.brkc) and draws new chunks from
+ * instead of generating them.
+ * Then reopens the file, checks every chunk unpacks to what was generated and prints the per-pattern counts, file size
+ * and the cost of unpacking a chunk against generating one.
+ *
+ * Build from the repo root alongside the game sources (everything except program.cpp):
+ *     skm clang++ -O2 tools/chunk_corpus.cpp $(ls *.cpp | grep -v program.cpp) -o chunk_corpus
+ *
+ * Usage:
+ *     ./chunk_corpus [out=chunks.brkc] [per_size=64] [seed=1]
+ */
+
+#include "../include/globals.h"
+#include "../include/types.h"
+#include "../include/state_init.h"
+#include "../include/terrain_patterns.h"
+#include "../include/chunk_corpus.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const char* PATTERN_NAMES[NUM_PATTERNS] = {"sine landscape", "grid", "sine", "circle lattice", "cave", "vein", "strata"};
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "chunks.brkc";
+    int per_size = argc > 2 ? std::atoi(argv[2]) : 64;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 0)) : 1;
+    if (per_size <= 0) return 0;
+
+    // the same pattern pick and chunk widths as add_new_chunk()
+    static constexpr PatternKind patterns[] = {PATTERN_SINE_LANDSCAPE, PATTERN_GRID, PATTERN_SINE, PATTERN_CIRCLE_LATTICE,
+                                               PATTERN_CAVE, PATTERN_VEIN, PATTERN_STRATA};
+    XOR rng(seed ? seed : 1);
+    std::vector<CorpusEntry> entries;
+    auto start = std::chrono::steady_clock::now();
+    for (int rows = 1; rows <= NUM_ROWS; ++rows) {
+        for (int i = 0; i < per_size; ++i) {
+            PatternKind pattern = rng.choose(patterns);
+            int cols = rng.randomInt(20, NUM_COLS);
+            entries.push_back({pattern, generate_chunk(pattern, rows, cols, rng)});
+        }
+    }
+    double generate_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    if (!save_chunk_corpus(entries, path)) {
+        fprintf(stderr, "couldn't write %s\n", path.c_str());
+        return 1;
+    }
+    ChunkCorpus corpus = new_chunk_corpus();
+    if (!open_chunk_corpus(corpus, path)) {
+        fprintf(stderr, "couldn't open %s\n", path.c_str());
+        return 1;
+    }
+
+    // entries were added in size order, the same order the corpus keeps them in
+    int pattern_counts[NUM_PATTERNS] = {};
+    int mismatches = 0;
+    Chunk chunk = new_chunk(0);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < corpus.num_chunks; ++i) {
+        corpus_chunk(corpus, i, chunk);
+        ++pattern_counts[corpus_pattern(corpus, i)];
+        mismatches += chunk.rows != entries[i].chunk.rows || chunk.hp != entries[i].chunk.hp;
+    }
+    double unpack_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%u chunks (%d of each size, seed %u) in %s, %zu bytes (%s)\n", corpus.num_chunks, per_size, seed, path.c_str(),
+           corpus.size, corpus.mapped ? "mapped" : "read");
+    for (int p = 0; p < NUM_PATTERNS; ++p) {
+        printf("  %-16s %d\n", PATTERN_NAMES[p], pattern_counts[p]);
+    }
+    printf("generate %.2fus/chunk, unpack %.2fus/chunk, %d mismatched\n", generate_us / entries.size(),
+           unpack_us / corpus.num_chunks, mismatches);
+    close_chunk_corpus(corpus);
+    return mismatches ? 1 : 0;
+}
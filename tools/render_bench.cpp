@@ -0,0 +1,73 @@
+/**
+ * @brief Headless render benchmark and golden-frame check.
+ * @details Plays a seeded game with the autopilot paddle and draws every frame with the software rasterizer,
+ * then prints the mean time and draw calls per render pass, and the hash of the final frame.
+ * The same seed and settings always give the same frame hash, so a known hash can be passed back in to check
+ * a change didn't alter the picture (the tool exits with 1 on a mismatch).
+ * Build with -DRASTER_NO_SIMD to time the scalar span fill instead.
+ *
+ * Build from the repo root alongside the game sources (everything except program.cpp):
+ *     skm clang++ -O2 tools/render_bench.cpp $(ls *.cpp | grep -v program.cpp) -o render_bench
+ *
+ * Usage:
+ *     ./render_bench [frames=600] [start_balls=20] [seed=1] [expected_hash=0 (skip check)] [final_frame.ppm]
+ */
+
+#include "../include/globals.h"
+#include "../include/types.h"
+#include "../include/state_management.h"
+#include "../include/state_init.h"
+#include "../include/terrain_patterns.h"
+#include "../include/ball_effects.h"
+#include "../include/draw.h"
+#include "../include/renderer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 600;
+    int start_balls = argc > 2 ? std::atoi(argv[2]) : 20;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 0)) : 1;
+    uint64_t expected = argc > 4 ? std::strtoull(argv[4], nullptr, 0) : 0;
+    const char* ppm_path = argc > 5 ? argv[5] : nullptr;
+
+    GameState game = new_game_state(seed);
+    set_terrain(game, sine_landscape(NUM_ROWS, NUM_COLS, game.rng.terrain));
+    game.paddle.autopilot = true;
+    for (int i = 0; i < start_balls; ++i) {
+        Ball b = roll_ball(game.rng.gameplay);
+        b.pos = {static_cast<double>(game.paddle.x + game.paddle.width / 2), static_cast<double>(game.paddle.y - 20)};
+        spawn_ball(game, b);
+    }
+
+    Renderer renderer = new_software_renderer(WINDOW_WIDTH, WINDOW_HEIGHT);
+    long particles_drawn = 0;
+    double frame_us = 0;
+    for (int f = 0; f < frames; ++f) {
+        update_global_state(game);
+        particles_drawn += game.particles.size();
+        auto start = std::chrono::steady_clock::now();
+        draw_global_state(game, renderer);
+        frame_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (renderer.frames == 0) return 0;
+
+    printf("%d frames at %dx%d, %.1f particles and %.1f draw calls per frame\n", renderer.frames, WINDOW_WIDTH, WINDOW_HEIGHT,
+           static_cast<double>(particles_drawn) / renderer.frames, static_cast<double>(renderer.draw_calls) / renderer.frames);
+    for (int pass = 0; pass < NUM_RENDER_PASSES; ++pass) {
+        printf("%-12s %8.1f us/frame\n", render_pass_name(static_cast<RenderPass>(pass)), renderer.pass_us[pass] / renderer.frames);
+    }
+    printf("%-12s %8.1f us/frame\n", "total", frame_us / renderer.frames);
+
+    uint64_t hash = frame_hash(renderer.framebuffer);
+    printf("final frame hash 0x%016llx\n", static_cast<unsigned long long>(hash));
+    if (ppm_path && !write_ppm(renderer.framebuffer, ppm_path)) {
+        printf("couldn't write %s\n", ppm_path);
+    }
+    if (expected != 0 && hash != expected) {
+        printf("MISMATCH, expected 0x%016llx\n", static_cast<unsigned long long>(expected));
+        return 1;
+    }
+    return 0;
+}